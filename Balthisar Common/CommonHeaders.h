@@ -108,6 +108,17 @@
     #define APP_GROUP_PREFS @"9PN2JXXG7Y.com.balthisar.Balthisar-Tidy.prefs"
 
 
+/*=======================================================*
+  The budgets for the tidying that the service helper and
+  the extensions do on behalf of other applications, so
+  that a hostile selection can't hang them.
+ *=======================================================*/
+#pragma mark - Service Tidying Budgets
+
+    #define JSDServiceTidyTimeBudget              10.0
+    #define JSDServiceTidyMemoryBudget            ((NSUInteger)512 * 1024 * 1024)
+
+
 /*=======================================================*
   These defs determine which features and other version-
   specific behaviors and settings apply to a target when
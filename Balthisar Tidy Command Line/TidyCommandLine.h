@@ -0,0 +1,38 @@
+//
+//  TidyCommandLine.h
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+/**
+ *  This class implements @b tidy-batch, the headless command line driver for
+ *  JSDTidyFramework. It tidies files and directory trees in parallel with a
+ *  @c JSDTidyBatchProcessor, writes the outputs atomically, and reports how
+ *  long each file took and the throughput of the whole run.
+ *
+ *  It uses only Foundation and the AppKit-free parts of JSDTidyFramework
+ *  (the option set, the batch processor, and the result cache), so that it
+ *  can run where there is no window server.
+ */
+@interface TidyCommandLine : NSObject
+
+/**
+ *  Initializes the command with its arguments.
+ *
+ *  @param arguments The command line arguments, not including the name
+ *    of the program.
+ */
+- (instancetype)initWithArguments:(NSArray<NSString *> *)arguments NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  Runs the command.
+ *
+ *  @returns The exit status: 0 if every file was clean, 1 if there were
+ *    warnings, and 2 if there were errors, if any file couldn't be read or
+ *    written, or if the arguments were wrong, just like @b tidy.
+ */
+- (int)run;
+
+@end
@@ -0,0 +1,724 @@
+//
+//  TidyCommandLine.m
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "TidyCommandLine.h"
+
+#import <JSDTidyFramework/JSDTidyOptionSet.h>
+#import <JSDTidyFramework/JSDTidyResultCache.h>
+#import <JSDTidyFramework/JSDTidyBatchProcessor.h>
+#import <JSDTidyFramework/JSDTidyMessage.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+
+#pragma mark - Definitions
+
+
+/* The extensions of the files that are tidied when a directory is given. */
+#define TidyCommandLineDefaultExtensions @"html,htm,xhtml,shtml"
+
+/* Throughput is reported in decimal megabytes, as the Finder does. */
+#define TidyCommandLineBytesPerMB 1000000.0
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * TidyCommandLineNow
+ *   Seconds on the monotonic clock. The tool sticks to POSIX here,
+ *   as it does for its lock, so that it builds beyond Darwin.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSTimeInterval TidyCommandLineNow( void )
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + (double)now.tv_nsec / NSEC_PER_SEC;
+}
+
+
+#pragma mark - CATEGORY TidyCommandLine ()
+
+
+@interface TidyCommandLine ()
+
+@property (nonatomic, strong) NSArray<NSString *> *arguments;
+
+/* Options */
+
+@property (nonatomic, strong) NSURL *configURL;
+
+@property (nonatomic, strong) NSURL *outputDirectoryURL;
+
+@property (nonatomic, strong) NSURL *cacheURL;
+
+@property (nonatomic, strong) NSSet<NSString *> *extensions;
+
+@property (nonatomic, assign) NSUInteger jobCount;
+
+@property (nonatomic, assign) BOOL modifyInPlace;
+
+@property (nonatomic, assign) BOOL quiet;
+
+@property (nonatomic, assign) BOOL showHelp;
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *paths;
+
+/* Inputs; the arrays are parallel, and indexed by the result index. */
+
+@property (nonatomic, strong) NSMutableArray<NSURL *> *inputURLs;
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *displayPaths;
+
+@property (nonatomic, strong) NSMutableArray<NSString *> *relativePaths;
+
+@end
+
+
+#pragma mark - IMPLEMENTATION
+
+
+@implementation TidyCommandLine
+{
+    pthread_mutex_t _lock;         // Guards the totals and the output streams.
+
+    NSUInteger _fileCount;
+    NSUInteger _failureCount;
+    uint64_t _byteCount;
+    NSTimeInterval _tidyTime;
+    uint _errorCount;
+    uint _warningCount;
+    int _status;
+}
+
+
+#pragma mark - Initialization
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - init
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)init
+{
+    return [self initWithArguments:@[]];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithArguments:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithArguments:(NSArray<NSString *> *)arguments
+{
+    if (self = [super init])
+    {
+        _arguments     = arguments;
+        _extensions    = [self extensionsFromList:TidyCommandLineDefaultExtensions];
+        _paths         = [[NSMutableArray alloc] init];
+        _inputURLs     = [[NSMutableArray alloc] init];
+        _displayPaths  = [[NSMutableArray alloc] init];
+        _relativePaths = [[NSMutableArray alloc] init];
+
+        pthread_mutex_init(&_lock, NULL);
+    }
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - dealloc
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)dealloc
+{
+    pthread_mutex_destroy(&_lock);
+}
+
+
+#pragma mark - Running
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - run
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (int)run
+{
+    if (![self parseArguments])
+    {
+        [self printUsageToStream:stderr];
+        return 2;
+    }
+
+    if (self.showHelp)
+    {
+        [self printUsageToStream:stdout];
+        return 0;
+    }
+
+    /* As with HTML Tidy, options that aren't in the configuration file
+     * keep their built-in defaults. Unlike the application, we take the
+     * encodings from the file, too, since there's no other way to set
+     * them.
+     */
+    JSDTidyOptionSet *optionSet = [JSDTidyOptionSet optionSetWithBuiltInDefaults];
+
+    if (self.configURL)
+    {
+        optionSet = [JSDTidyOptionSet optionSetWithConfigFile:self.configURL includingEncodings:YES];
+
+        if (!optionSet)
+        {
+            fprintf(stderr, "tidy-batch: can't load the configuration file %s\n", self.configURL.path.UTF8String);
+            return 2;
+        }
+    }
+
+    if (![self collectInputs])
+    {
+        return 2;
+    }
+
+    if (self.inputURLs.count == 0)
+    {
+        fprintf(stderr, "tidy-batch: no files to tidy\n");
+        return 0;
+    }
+
+    JSDTidyBatchProcessor *processor = [[JSDTidyBatchProcessor alloc] initWithOptionSet:optionSet];
+
+    if (self.jobCount > 0)
+    {
+        processor.workerCount = self.jobCount;
+    }
+
+    /* When nothing is written, there's no reason to print the documents. */
+    if (!self.outputDirectoryURL && !self.modifyInPlace)
+    {
+        processor.runMode = JSDTidyRunModeDiagnosticsOnly;
+    }
+
+    if (self.cacheURL)
+    {
+        /* Nothing is kept in memory; each file is seen only once per run. */
+        JSDTidyResultCache *cache = [[JSDTidyResultCache alloc] initWithMemoryLimit:0];
+
+        cache.persistentStoreURL = self.cacheURL;
+        processor.resultCache = cache;
+    }
+
+    NSTimeInterval start = TidyCommandLineNow();
+
+    [processor processFileURLs:self.inputURLs resultHandler:^(JSDTidyBatchResult *result) {
+        [self finishResult:result];
+    }];
+
+    NSTimeInterval wallTime = TidyCommandLineNow() - start;
+
+    [processor.resultCache synchronizePersistentStore];
+
+    [self printTotalsWithWallTime:wallTime
+                      workerCount:MIN(processor.workerCount, self.inputURLs.count)
+                            cache:processor.resultCache];
+
+    return _status;
+}
+
+
+#pragma mark - Private
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - parseArguments (private)
+ *    Options are spelled as tidy spells them, with a single dash,
+ *    but GNU-style double dashes are accepted, too.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)parseArguments
+{
+    NSEnumerator *enumerator = [self.arguments objectEnumerator];
+    NSString *argument;
+    BOOL onlyPaths = NO;
+
+    while ((argument = [enumerator nextObject]))
+    {
+        if (onlyPaths || ![argument hasPrefix:@"-"] || argument.length == 1)
+        {
+            [self.paths addObject:argument];
+            continue;
+        }
+
+        if ([argument isEqualToString:@"--"])
+        {
+            onlyPaths = YES;
+            continue;
+        }
+
+        NSString *option = [argument hasPrefix:@"--"] ? [argument substringFromIndex:2] : [argument substringFromIndex:1];
+
+        if ([option isEqualToString:@"h"] || [option isEqualToString:@"help"])
+        {
+            self.showHelp = YES;
+            return YES;
+        }
+        else if ([option isEqualToString:@"m"] || [option isEqualToString:@"modify"])
+        {
+            self.modifyInPlace = YES;
+            continue;
+        }
+        else if ([option isEqualToString:@"q"] || [option isEqualToString:@"quiet"])
+        {
+            self.quiet = YES;
+            continue;
+        }
+
+        NSArray *valueOptions = @[ @"config", @"output-dir", @"jobs", @"ext", @"cache" ];
+
+        if (![valueOptions containsObject:option])
+        {
+            fprintf(stderr, "tidy-batch: unknown option %s\n", argument.UTF8String);
+            return NO;
+        }
+
+        NSString *value = [enumerator nextObject];
+
+        if (!value)
+        {
+            fprintf(stderr, "tidy-batch: %s requires a value\n", argument.UTF8String);
+            return NO;
+        }
+
+        if ([option isEqualToString:@"config"])
+        {
+            self.configURL = [NSURL fileURLWithPath:value];
+        }
+        else if ([option isEqualToString:@"output-dir"])
+        {
+            self.outputDirectoryURL = [NSURL fileURLWithPath:value isDirectory:YES];
+        }
+        else if ([option isEqualToString:@"cache"])
+        {
+            self.cacheURL = [NSURL fileURLWithPath:value isDirectory:YES];
+        }
+        else if ([option isEqualToString:@"ext"])
+        {
+            self.extensions = [self extensionsFromList:value];
+        }
+        else if ([option isEqualToString:@"jobs"])
+        {
+            if (value.integerValue <= 0)
+            {
+                fprintf(stderr, "tidy-batch: %s requires a positive number\n", argument.UTF8String);
+                return NO;
+            }
+
+            self.jobCount = value.integerValue;
+        }
+    }
+
+    if (self.modifyInPlace && self.outputDirectoryURL)
+    {
+        fprintf(stderr, "tidy-batch: -modify and -output-dir can't be used together\n");
+        return NO;
+    }
+
+    /* Checks don't produce the complete results that the cache keeps. */
+    if (self.cacheURL && !self.modifyInPlace && !self.outputDirectoryURL)
+    {
+        fprintf(stderr, "tidy-batch: -cache requires -modify or -output-dir\n");
+        return NO;
+    }
+
+    if (self.paths.count == 0)
+    {
+        fprintf(stderr, "tidy-batch: no files or directories were given\n");
+        return NO;
+    }
+
+    return YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - extensionsFromList: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSSet<NSString *> *)extensionsFromList:(NSString *)list
+{
+    NSMutableSet *extensions = [[NSMutableSet alloc] init];
+
+    for (NSString *component in [list componentsSeparatedByString:@","])
+    {
+        NSString *extension = [component stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@". "]];
+
+        if (extension.length > 0)
+        {
+            [extensions addObject:extension.lowercaseString];
+        }
+    }
+
+    return extensions;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - collectInputs (private)
+ *    Files are tidied whatever their extensions; directories are
+ *    searched for files with the extensions, skipping hidden ones.
+ *    The relative paths are where the outputs go in -output-dir.
+ *    Two inputs may never have the same destination, or one would
+ *    silently replace the other's output.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)collectInputs
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+
+    for (NSString *path in self.paths)
+    {
+        BOOL isDirectory = NO;
+
+        if (![fileManager fileExistsAtPath:path isDirectory:&isDirectory])
+        {
+            fprintf(stderr, "tidy-batch: %s: no such file or directory\n", path.UTF8String);
+            return NO;
+        }
+
+        NSURL *rootURL = [NSURL fileURLWithPath:path isDirectory:isDirectory];
+
+        if (!isDirectory)
+        {
+            [self.inputURLs addObject:rootURL];
+            [self.displayPaths addObject:path];
+            [self.relativePaths addObject:path.lastPathComponent];
+            continue;
+        }
+
+        NSString *rootPath = rootURL.path;
+
+        NSDirectoryEnumerator *enumerator = [fileManager enumeratorAtURL:rootURL
+                                              includingPropertiesForKeys:@[ NSURLIsRegularFileKey ]
+                                                                 options:NSDirectoryEnumerationSkipsHiddenFiles
+                                                            errorHandler:nil];
+
+        for (NSURL *fileURL in enumerator)
+        {
+            NSNumber *isRegularFile = nil;
+
+            [fileURL getResourceValue:&isRegularFile forKey:NSURLIsRegularFileKey error:NULL];
+
+            if (!isRegularFile.boolValue || ![self.extensions containsObject:fileURL.pathExtension.lowercaseString])
+            {
+                continue;
+            }
+
+            NSString *relativePath = fileURL.lastPathComponent;
+
+            if ([fileURL.path hasPrefix:[rootPath stringByAppendingString:@"/"]])
+            {
+                relativePath = [fileURL.path substringFromIndex:rootPath.length + 1];
+            }
+
+            [self.inputURLs addObject:fileURL];
+            [self.displayPaths addObject:[path stringByAppendingPathComponent:relativePath]];
+            [self.relativePaths addObject:relativePath];
+        }
+    }
+
+    return [self checkDestinations];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - checkDestinations (private)
+ *    With -output-dir, every input's relative path must be unique;
+ *    with -modify, every input must be a different file.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)checkDestinations
+{
+    if (!self.outputDirectoryURL && !self.modifyInPlace)
+    {
+        return YES;
+    }
+
+    NSMutableDictionary<NSString *, NSString *> *destinations = [[NSMutableDictionary alloc] init];
+
+    for (NSUInteger i = 0; i < self.inputURLs.count; i++)
+    {
+        NSString *destination = self.outputDirectoryURL ? self.relativePaths[i] : self.inputURLs[i].URLByResolvingSymlinksInPath.path;
+        NSString *otherPath = destinations[destination];
+
+        if (otherPath)
+        {
+            fprintf(stderr, "tidy-batch: %s and %s would be written to the same file\n", otherPath.UTF8String, self.displayPaths[i].UTF8String);
+            return NO;
+        }
+
+        destinations[destination] = self.displayPaths[i];
+    }
+
+    return YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - writeResult: (private)
+ *    Writes the output atomically, so that an interrupted run never
+ *    leaves a partial file behind, and never replaces an input with
+ *    one. Returns a description of the failure, or nil.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)writeResult:(JSDTidyBatchResult *)result
+{
+    /* Like tidy, don't write anything when there's no output, i.e.,
+     * when there were errors and force-output is off.
+     */
+    if (result.tidyTextAsUTF8Data.length == 0)
+    {
+        return nil;
+    }
+
+    NSData *data = result.tidyTextAsData;
+
+    if (!data)
+    {
+        return @"couldn't be encoded in the output encoding";
+    }
+
+    if (self.modifyInPlace)
+    {
+        return [self replaceFileAtURL:self.inputURLs[result.index] withData:data];
+    }
+
+    NSURL *destinationURL = [self.outputDirectoryURL URLByAppendingPathComponent:self.relativePaths[result.index]];
+    NSError *error = nil;
+
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:destinationURL.URLByDeletingLastPathComponent
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:&error])
+    {
+        return [NSString stringWithFormat:@"couldn't be written: %@", error.localizedDescription];
+    }
+
+    if (![data writeToURL:destinationURL options:NSDataWritingAtomic error:&error])
+    {
+        return [NSString stringWithFormat:@"couldn't be written: %@", error.localizedDescription];
+    }
+
+    return nil;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - replaceFileAtURL:withData: (private)
+ *    For -modify. A symlink's target is replaced rather than the
+ *    link itself, and replaceItemAtURL: keeps the original's
+ *    permissions, extended attributes, and ACLs, which a plain
+ *    atomic write would reset. Returns a description of the
+ *    failure, or nil.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)replaceFileAtURL:(NSURL *)fileURL withData:(NSData *)data
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSURL *originalURL = fileURL.URLByResolvingSymlinksInPath;
+    NSError *error = nil;
+
+    NSURL *temporaryDirectoryURL = [fileManager URLForDirectory:NSItemReplacementDirectory
+                                                       inDomain:NSUserDomainMask
+                                              appropriateForURL:originalURL
+                                                         create:YES
+                                                          error:&error];
+
+    if (!temporaryDirectoryURL)
+    {
+        return [NSString stringWithFormat:@"couldn't be written: %@", error.localizedDescription];
+    }
+
+    NSURL *temporaryURL = [temporaryDirectoryURL URLByAppendingPathComponent:originalURL.lastPathComponent];
+    NSString *failure = nil;
+
+    if (![data writeToURL:temporaryURL options:0 error:&error] ||
+        ![fileManager replaceItemAtURL:originalURL
+                         withItemAtURL:temporaryURL
+                        backupItemName:nil
+                               options:0
+                      resultingItemURL:nil
+                                 error:&error])
+    {
+        failure = [NSString stringWithFormat:@"couldn't be written: %@", error.localizedDescription];
+    }
+
+    [fileManager removeItemAtURL:temporaryDirectoryURL error:nil];
+
+    return failure;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - finishResult: (private)
+ *    Called on the worker threads. The output is written outside of
+ *    the lock; only the totals and the printing are serialized.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)finishResult:(JSDTidyBatchResult *)result
+{
+    NSString *displayPath = self.displayPaths[result.index];
+    NSString *failure = nil;
+
+    if (result.error)
+    {
+        failure = [NSString stringWithFormat:@"couldn't be read: %@", result.error.localizedDescription];
+    }
+    else if (self.outputDirectoryURL || self.modifyInPlace)
+    {
+        failure = [self writeResult:result];
+    }
+
+    NSTimeInterval elapsed = result.elapsedTime;
+    double throughput = elapsed > 0 ? result.sourceByteCount / elapsed / TidyCommandLineBytesPerMB : 0;
+
+    NSString *line;
+
+    if (failure)
+    {
+        line = [NSString stringWithFormat:@"%@: %@", displayPath, failure];
+    }
+    else
+    {
+        line = [NSString stringWithFormat:@"%@: %lu bytes in %.2f ms (%.2f MB/s), %u errors, %u warnings%@",
+                displayPath,
+                (unsigned long)result.sourceByteCount,
+                elapsed * 1000,
+                throughput,
+                result.tidyErrorCount,
+                result.tidyWarningCount,
+                result.tidyResultWasCached ? @", cached" : @""];
+    }
+
+    pthread_mutex_lock(&_lock);
+
+    _fileCount++;
+    _byteCount    += result.sourceByteCount;
+    _tidyTime     += elapsed;
+    _errorCount   += result.tidyErrorCount;
+    _warningCount += result.tidyWarningCount;
+
+    if (failure || result.tidyStatus < 0)
+    {
+        _failureCount += failure ? 1 : 0;
+        _status = 2;
+    }
+    else
+    {
+        _status = MAX(_status, result.tidyStatus);
+    }
+
+    fprintf(stdout, "%s\n", line.UTF8String);
+
+    if (!self.quiet && result.errorArray.count > 0)
+    {
+        fprintf(stderr, "%s:\n%s", displayPath.UTF8String, [self messagesTextForResult:result].UTF8String);
+    }
+
+    pthread_mutex_unlock(&_lock);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - messagesTextForResult: (private)
+ *    Formats the messages as tidy prints them. They're taken from
+ *    the message array rather than errorText, because checks don't
+ *    produce any errorText.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)messagesTextForResult:(JSDTidyBatchResult *)result
+{
+    NSMutableString *text = [[NSMutableString alloc] init];
+
+    for (JSDTidyMessage *message in result.errorArray)
+    {
+        NSString *level;
+
+        switch (message.level)
+        {
+            case TidyInfo:        level = @"Info";     break;
+            case TidyWarning:     level = @"Warning";  break;
+            case TidyConfig:      level = @"Config";   break;
+            case TidyAccess:      level = @"Access";   break;
+            case TidyError:       level = @"Error";    break;
+            case TidyBadDocument: level = @"Document"; break;
+            case TidyFatal:       level = @"Panic";    break;
+            default:              level = @"Info";     break;
+        }
+
+        if (message.line > 0)
+        {
+            [text appendFormat:@"line %u column %u - %@: %@\n", message.line, message.column, level, message.message];
+        }
+        else
+        {
+            [text appendFormat:@"%@: %@\n", level, message.message];
+        }
+    }
+
+    return text;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - printTotalsWithWallTime:workerCount:cache: (private)
+ *    The tidy time is the sum of the per-file times, so dividing it
+ *    by the wall time shows how well the workers were kept busy.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)printTotalsWithWallTime:(NSTimeInterval)wallTime workerCount:(NSUInteger)workerCount cache:(JSDTidyResultCache *)cache
+{
+    double megabytes = _byteCount / TidyCommandLineBytesPerMB;
+
+    fprintf(stdout, "\n%lu files, %.2f MB in %.2f s: %.2f MB/s, %.1f files/s\n",
+            (unsigned long)_fileCount,
+            megabytes,
+            wallTime,
+            wallTime > 0 ? megabytes / wallTime : 0,
+            wallTime > 0 ? _fileCount / wallTime : 0);
+
+    fprintf(stdout, "%.2f s of tidying on %lu workers (%.1fx parallelism)\n",
+            _tidyTime,
+            (unsigned long)workerCount,
+            wallTime > 0 ? _tidyTime / wallTime : 0);
+
+    fprintf(stdout, "%u errors, %u warnings, %lu failures\n",
+            _errorCount,
+            _warningCount,
+            (unsigned long)_failureCount);
+
+    if (cache)
+    {
+        fprintf(stdout, "cache: %lu hits, %lu misses\n",
+                (unsigned long)cache.hitCount,
+                (unsigned long)cache.missCount);
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - printUsageToStream: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)printUsageToStream:(FILE *)stream
+{
+    fprintf(stream,
+            "usage: tidy-batch [options] file-or-directory ...\n"
+            "\n"
+            "Tidies files and directory trees in parallel. Without -modify or\n"
+            "-output-dir, the files are only checked.\n"
+            "\n"
+            "  -config FILE      load the Tidy options from a configuration FILE\n"
+            "  -output-dir DIR   write the tidied files into DIR, mirroring directories\n"
+            "  -m, -modify       replace each file with its tidied version\n"
+            "  -jobs N           use N worker threads (default: one per core)\n"
+            "  -ext LIST         extensions to tidy in directories (default: %s)\n"
+            "  -cache DIR        keep results in DIR, and reuse them on later runs;\n"
+            "                    requires -modify or -output-dir\n"
+            "  -q, -quiet        don't print Tidy's messages\n"
+            "  -h, -help         show this help\n",
+            TidyCommandLineDefaultExtensions.UTF8String);
+}
+
+
+@end
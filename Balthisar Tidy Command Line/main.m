@@ -0,0 +1,21 @@
+/**************************************************************************************************
+
+ main.m
+
+ Copyright © 2003-2019 by Jim Derry. All rights reserved.
+
+ **************************************************************************************************/
+
+@import Foundation;
+
+#import "TidyCommandLine.h"
+
+int main(int argc, const char * argv[]) {
+    @autoreleasepool {
+        NSArray *arguments = [NSProcessInfo processInfo].arguments;
+
+        arguments = [arguments subarrayWithRange:NSMakeRange(1, arguments.count - 1)];
+
+        return [[[TidyCommandLine alloc] initWithArguments:arguments] run];
+    }
+}
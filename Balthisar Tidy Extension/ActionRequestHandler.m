@@ -45,6 +45,8 @@
     /* Set options and perform the Tidying.
      */
     JSDTidyModel *localModel = [[JSDTidyModel alloc] init];
+    localModel.timeBudget = JSDServiceTidyTimeBudget;
+    localModel.memoryBudget = JSDServiceTidyMemoryBudget;
     [localModel takeOptionValuesFromDefaults:localDefaults];
     JSDTidyOption *localOption = localModel.tidyOptions[@"force-output"];
     localOption.optionValue = @"YES";
@@ -10,6 +10,8 @@
 #import "CommonHeaders.h"
 #import "JSDScriptSuiteRegistry.h"
 
+@import JSDTidyFramework;
+
 
 @interface AppDelegate ()
 
@@ -50,6 +52,17 @@
      */
     NSRegisterServicesProvider(tidyService, @"com.balthisar.service.port");
 
+    /* Services and scripts tend to tidy the same text over and over, so
+     * keep results from one launch to the next.
+     */
+    NSURL *cachesURL = [[NSFileManager defaultManager] URLForDirectory:NSCachesDirectory
+                                                              inDomain:NSUserDomainMask
+                                                     appropriateForURL:nil
+                                                                create:YES
+                                                                 error:nil];
+
+    [JSDTidyResultCache sharedCache].persistentStoreURL = [cachesURL URLByAppendingPathComponent:@"TidyResults" isDirectory:YES];
+
     /* If started by simply launching Balthisar Tidy, quit immediately.
      * This message will be sent by Balthisar Tidy soon after launching.
      */
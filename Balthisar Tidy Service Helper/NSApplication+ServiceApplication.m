@@ -59,19 +59,23 @@ static char sourceTextKey;
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (NSString *)performTidy:(NSString *)sourceText bodyOnly:(BOOL)bodyOnly
 {
-    JSDTidyModel *localModel = [[JSDTidyModel alloc] initWithString:sourceText];
+    JSDTidyModel *localModel = [[JSDTidyModel alloc] init];
     NSUserDefaults *localDefaults = [(AppDelegate*)[self delegate] sharedUserDefaults];
 
+    localModel.timeBudget = JSDServiceTidyTimeBudget;
+    localModel.memoryBudget = JSDServiceTidyMemoryBudget;
+
     [localModel takeOptionValuesFromDefaults:localDefaults];
     JSDTidyOption *localOption = localModel.tidyOptions[@"force-output"];
     localOption.optionValue = @"YES";
     
-    localOption = localModel.tidyOptions[@"show-body-only"];
-    localOption.optionValue = bodyOnly ? @"1" : @"0";
-    
+    /* Get both texts from a single parse; the one that wasn't asked for
+     * only costs printing, and is cached for the other property.
+     */
     localModel.sourceText = sourceText;
+    NSDictionary *localTidyTexts = [localModel tidyTextsForOutputProfiles:@[ JSDTidyOutputProfileDocument, JSDTidyOutputProfileBodyOnly ]];
     
-    return localModel.tidyText;
+    return localTidyTexts[bodyOnly ? JSDTidyOutputProfileBodyOnly : JSDTidyOutputProfileDocument];
 }
 
 
@@ -57,23 +57,26 @@
     
     NSString *pboardString = [pboard stringForType:NSPasteboardTypeString];
     
-    JSDTidyModel *localModel = [[JSDTidyModel alloc] initWithString:pboardString];
+    JSDTidyModel *localModel = [[JSDTidyModel alloc] init];
     NSUserDefaults *localDefaults = [[NSUserDefaults alloc] initWithSuiteName:APP_GROUP_PREFS];
 
+    localModel.timeBudget = JSDServiceTidyTimeBudget;
+    localModel.memoryBudget = JSDServiceTidyMemoryBudget;
+
     [localModel takeOptionValuesFromDefaults:localDefaults];
     JSDTidyOption *localOption = localModel.tidyOptions[@"force-output"];
     localOption.optionValue = @"YES";
     
-    localOption = localModel.tidyOptions[@"show-body-only"];
-    localOption.optionValue = bodyOnly ? @"1" : @"0";
-    
-    /* Grab a current copy of tidyText
+    /* Get both texts from a single parse; the one that wasn't asked for
+     * only costs printing, and is cached in case the other service is
+     * used on the same selection.
      */
     localModel.sourceText = pboardString;
-    NSString *localTidyText = localModel.tidyText;
+    NSDictionary *localTidyTexts = [localModel tidyTextsForOutputProfiles:@[ JSDTidyOutputProfileDocument, JSDTidyOutputProfileBodyOnly ]];
+    NSString *localTidyText = localTidyTexts[bodyOnly ? JSDTidyOutputProfileBodyOnly : JSDTidyOutputProfileDocument];
     
     
-    if (!localTidyText)
+    if (!localTidyText || localModel.tidyBudgetStatus != JSDTidyBudgetStatusWithinBudgets)
     {
         *error = JSDLocalizedString(@"tidyDidntWork", nil);
     }
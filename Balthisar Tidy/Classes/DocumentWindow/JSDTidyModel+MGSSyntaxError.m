@@ -4,22 +4,50 @@
 //  Copyright © 2003-2021 by Jim Derry. All rights reserved.
 //
 
+#import <objc/runtime.h>
 #import "JSDTidyModel+MGSSyntaxError.h"
 
+static char fragariaMessagesKey;
+static char fragariaErrorsKey;
+
 
 @implementation JSDTidyModel (MGSSyntaxError)
 
 
 /*———————————————————————————————————————————————————————————————————*
  * @property fragariaErrorArray
+ *  Syntax errors are cached along with the messages they were built
+ *  from. When the messages change, errors for messages that are
+ *  unchanged are reused, and only new messages are converted.
  *———————————————————————————————————————————————————————————————————*/
 - (NSArray<MGSSyntaxError *> *)fragariaErrorArray
 {
     NSArray *localErrors = self.errorArray;
-    NSMutableArray *highlightErrors = [[NSMutableArray alloc] init];
-    
+    NSArray *cachedMessages = objc_getAssociatedObject(self, &fragariaMessagesKey);
+    NSArray<MGSSyntaxError *> *cachedErrors = objc_getAssociatedObject(self, &fragariaErrorsKey);
+
+    if (cachedErrors && cachedMessages == localErrors)
+    {
+        return cachedErrors;
+    }
+
+    JSDTidyMessageChanges *changes = self.errorArrayChanges;
+    BOOL canReuse = cachedErrors && cachedMessages && changes.previousMessages == cachedMessages;
+
+    NSMutableArray *highlightErrors = [[NSMutableArray alloc] initWithCapacity:localErrors.count];
+    NSUInteger index = 0;
+
     for (NSDictionary *localError in localErrors)
     {
+        NSUInteger previousIndex = canReuse ? [changes previousIndexForIndex:index] : NSNotFound;
+        index++;
+
+        if (previousIndex != NSNotFound && previousIndex < cachedErrors.count)
+        {
+            [highlightErrors addObject:cachedErrors[previousIndex]];
+            continue;
+        }
+
         MGSSyntaxError *newError = [MGSSyntaxError new];
         newError.errorDescription = localError[@"message"];
         newError.line = [localError[@"line"] intValue];
@@ -29,8 +57,13 @@
         newError.warningImage = localError[@"levelImage"];
         [highlightErrors addObject:newError];
     }
-    
-    return highlightErrors;
+
+    NSArray<MGSSyntaxError *> *result = [highlightErrors copy];
+
+    objc_setAssociatedObject(self, &fragariaMessagesKey, localErrors, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    objc_setAssociatedObject(self, &fragariaErrorsKey, result, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+
+    return result;
 }
 
 
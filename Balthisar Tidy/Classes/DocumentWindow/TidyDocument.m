@@ -36,6 +36,7 @@
     if ((self = [super init]))
     {
         _tidyProcess = [[JSDTidyModel alloc] init];
+        _tidyProcess.tidyInBackground = YES;
         _documentOpenedData = nil;
         _documentIsLoading = NO;
         _fileWantsProtection = NO;
@@ -76,9 +77,12 @@
              ofType:(NSString *)typeName
               error:(NSError * __autoreleasing *)outError
 {
-    /* Save the data for use until after the Nib is awake.
+    /* Save the data for use until after the Nib is awake. The data
+     * are memory mapped where possible; `tidyProcess` copies them as
+     * soon as it's given them, and nothing reads the mapping after
+     * that, so a file that changes underneath us can't crash us.
      */
-    _documentOpenedData = [NSData dataWithContentsOfFile:absoluteURL];
+    _documentOpenedData = [NSData dataWithContentsOfFile:absoluteURL options:NSDataReadingMappedIfSafe error:nil];
     
     /* self.documentIsLoading is used later to prevent some multiple
      * notifications that aren't needed, and represents that we've
@@ -129,6 +133,9 @@
 - (NSData *)dataOfType:(NSString *)typeName
                  error:(NSError * __autoreleasing *)outError
 {
+    /* Don't save stale results if the user is typing. */
+    [self.tidyProcess finishPendingTidy];
+
     return self.tidyProcess.tidyTextAsData;
 }
 
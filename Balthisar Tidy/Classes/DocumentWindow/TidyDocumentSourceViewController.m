@@ -90,6 +90,18 @@
                                                  name:tidyNotifyOptionChanged
                                                object:[self.representedObject tidyProcess]];
     
+    /* Options that are set to the values they already have aren't
+     * announced, so start with the page guide where `wrap` is now.
+     */
+    JSDTidyOption *wrapOption = [[self.representedObject tidyProcess] tidyOptions][@"wrap"];
+    
+    if (wrapOption.optionValue)
+    {
+        [self handleTidyOptionChange:[NSNotification notificationWithName:tidyNotifyOptionChanged
+                                                                   object:[self.representedObject tidyProcess]
+                                                                 userInfo:@{@"wrap" : wrapOption.optionValue}]];
+    }
+    
     /* KVO on user prefs to look for Text Substitution Preference Changes.
      */
     [[NSUserDefaults standardUserDefaults] addObserver:self
@@ -311,11 +311,19 @@
  *  One or more options changed in `optionController`. Copy
  *  those options to our `tidyProcess`. The event chain will
  *  eventually update everything else because this will cause
- *  the tidyText to change.
+ *  the tidyText to change. The notification names the options
+ *  that changed, so only those are copied.
  *———————————————————————————————————————————————————————————————————*/
 - (void)handleTidyOptionChange:(NSNotification *)note
 {
-    [self.tidyProcess optionsCopyValuesFromModel:self.optionController.tidyDocument];
+    if (note.userInfo.count > 0)
+    {
+        [self.tidyProcess optionsCopyValuesFromDictionary:note.userInfo];
+    }
+    else
+    {
+        [self.tidyProcess optionsCopyValuesFromModel:self.optionController.tidyDocument];
+    }
 }
 
 
@@ -172,14 +172,29 @@ typedef NS_OPTIONS(NSUInteger, JSDNuVMessageTypes) {
 @property (nonatomic, strong, readonly) NSString *locationString;
 
 
+/**
+ *  The location packed into a single integer, @c firstLine in the upper
+ *  32 bits and @c firstColumn in the lower 32 bits, so that comparing
+ *  keys orders messages by line and then by column.
+ */
+@property (nonatomic, assign, readonly) uint64_t locationKey;
+
+/**
+ *  A hash of the message's type, subtype, and text, computed once when
+ *  the message is created.
+ */
+@property (nonatomic, assign, readonly) uint64_t messageKey;
+
 /**
  *  This property can be used to specify a sort order against
  *  the line number, column number, and localized description
- *  of a particular message.
+ *  of a particular message. It's the message itself, which sorts
+ *  with @c compare: using the packed keys, so it's suitable as the
+ *  key for an @c NSSortDescriptor.
  *
  *  It's suggested to use the custom comparitor instead.
  */
-@property (nonatomic, strong, readonly) NSString *sortKey;
+@property (nonatomic, strong, readonly) JSDNuVMessage *sortKey;
 
 
 #pragma mark - Instance Methods
@@ -204,5 +219,14 @@ typedef NS_OPTIONS(NSUInteger, JSDNuVMessageTypes) {
 -(NSComparisonResult)validatorMessageLocationCompare:(JSDNuVMessage *)message;
 
 
+/**
+ *  The same as @c validatorMessageLocationCompare:, so that @c sortKey
+ *  can be used with the default @c NSSortDescriptor selector.
+ *  @param message An instance of JSDValidatorMessage to be
+ *  compared against.
+ */
+-(NSComparisonResult)compare:(JSDNuVMessage *)message;
+
+
 @end
 
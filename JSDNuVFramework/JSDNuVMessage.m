@@ -20,6 +20,30 @@
 @end
 
 
+#pragma mark - Message Keys
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDNuVMessageHashString
+ *   FNV-1a, 64 bit, over the string's UTF-8 and a terminator, so
+ *   that consecutive strings can't run together.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static uint64_t JSDNuVMessageHashString( uint64_t hash, NSString *string )
+{
+    const uint8_t *byte = (const uint8_t *)string.UTF8String;
+
+    if ( byte )
+    {
+        for ( ; *byte; byte++ )
+        {
+            hash = (hash ^ *byte) * 0x100000001b3ULL;
+        }
+    }
+
+    return (hash ^ 0xFF) * 0x100000001b3ULL;
+}
+
+
 #pragma mark - Implementation
 
 @implementation JSDNuVMessage
@@ -53,6 +77,17 @@
     if ( (self = [super init]) )
     {
         _dictionary = [dict copy];
+
+        /* The dictionary doesn't change, so the keys are computed once. */
+
+        uint64_t hash = 0xcbf29ce484222325ULL;
+
+        hash = JSDNuVMessageHashString(hash, [_dictionary valueForKey:@"type"]);
+        hash = JSDNuVMessageHashString(hash, [_dictionary valueForKey:@"subtype"]);
+        hash = JSDNuVMessageHashString(hash, [_dictionary valueForKey:@"message"]);
+
+        _locationKey = ((uint64_t)self.firstLine << 32) | self.firstColumn;
+        _messageKey = hash;
     }
     
     return self;
@@ -438,10 +473,12 @@
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * @sortKey
+ *   Sort descriptors using this key call `compare:`, which uses the
+ *   packed keys rather than building a string for every message.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (NSString *)sortKey
+- (JSDNuVMessage *)sortKey
 {
-    return [NSString stringWithFormat:@"%08u%08u%@", self.firstLine, self.firstColumn, self.message];
+    return self;
 }
 
 
@@ -470,10 +507,7 @@
         return NO;
     }
     
-    BOOL equalLocationString = [self.locationString isEqualToString:message.locationString];
-    BOOL equalMessage = [self.message isEqualToString:message.message];
-    
-    return equalLocationString && equalMessage;
+    return (self.locationKey == message.locationKey) && (self.messageKey == message.messageKey);
 }
 
 
@@ -501,30 +535,40 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (NSUInteger)hash
 {
-    return [self.locationString hash] ^ [self.message hash];
+    return (NSUInteger)((self.locationKey * 0x9E3779B97F4A7C15ULL) ^ self.messageKey);
 }
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - tidyMessageLocationCompare:
+ * - validatorMessageLocationCompare:
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 -(NSComparisonResult)validatorMessageLocationCompare:(JSDNuVMessage *)message
 {
-    NSComparisonResult result;
-    
-    result = [@(self.firstLine) compare:@(message.firstLine)];
-    
-    if (result == NSOrderedSame)
+    uint64_t selfKey = self.locationKey;
+    uint64_t otherKey = message.locationKey;
+
+    if (selfKey != otherKey)
     {
-        result = [@(self.firstColumn) compare:@(message.firstColumn)];
-        
-        if (result == NSOrderedSame)
-        {
-            result = [self.message localizedStandardCompare:message.message];
-        }
+        return selfKey < otherKey ? NSOrderedAscending : NSOrderedDescending;
     }
-    
-    return result;
+
+    /* Only messages at the same location need their text. */
+
+    if (self.messageKey == message.messageKey)
+    {
+        return NSOrderedSame;
+    }
+
+    return [self.message localizedStandardCompare:message.message];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - compare:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+-(NSComparisonResult)compare:(JSDNuVMessage *)message
+{
+    return [self validatorMessageLocationCompare:message];
 }
 
 
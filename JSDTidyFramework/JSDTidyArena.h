@@ -0,0 +1,125 @@
+//
+//  JSDTidyArena.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+@import HTMLTidy;
+
+#include <setjmp.h>
+
+
+/** The budgets that an arena can enforce; see @c JSDTidyArenaSetBudgets(). */
+typedef NS_ENUM(NSUInteger, JSDTidyArenaBudget) {
+    JSDTidyArenaBudgetNone        = 0,
+    JSDTidyArenaBudgetTime        = 1,
+    JSDTidyArenaBudgetAllocations = 2,
+    JSDTidyArenaBudgetBytes       = 3,
+};
+
+
+/**
+ *  @c JSDTidyArena is a bump-pointer @c TidyAllocator for use with
+ *  @c tidyCreateWithAllocator(). @b libtidy allocates thousands of small
+ *  nodes and attributes for every parse; the arena hands them out from a
+ *  few large chunks instead of from @c malloc, and releases all of them
+ *  at once when it's reset.
+ *
+ *  Individual frees are ignored (aside from blocks that fell back to
+ *  @c malloc), so an arena is only suitable for a TidyDoc whose entire
+ *  lifetime ends before the arena is reset. Once the arena has reserved
+ *  @c limit bytes of chunks, or for very large requests, allocations fall
+ *  back to @c malloc and are tracked so that they are still released by
+ *  a reset.
+ *
+ *  An arena can also enforce budgets on the work done with it; see
+ *  @c JSDTidyArenaSetBudgets().
+ *
+ *  An arena is not thread-safe; use one arena per TidyDoc.
+ */
+typedef struct JSDTidyArena {
+    TidyAllocator allocator;       // Must be first; pass &arena->allocator to libtidy.
+    struct JSDTidyArenaChunk *chunks;
+    struct JSDTidyArenaFallback *fallbacks;
+    size_t limit;                  // Maximum bytes to reserve in chunks.
+    size_t reservedBytes;          // Bytes currently reserved in chunks.
+    size_t fallbackBytes;          // Bytes currently held by fallback blocks.
+    size_t liveBytes;              // Bytes requested and not yet freed.
+    size_t peakBytes;              // High water mark of liveBytes; logical bytes, not memory held.
+    size_t allocationCount;        // Number of allocations since the last reset.
+    size_t fallbackCount;          // Number of those that fell back to malloc.
+    size_t byteBudget;             // Most reservedBytes + fallbackBytes allowed; zero for no limit.
+    size_t allocationBudget;       // Most allocations allowed; zero for no limit.
+    uint64_t deadline;             // JSDTidyMonotonicTime() nanoseconds; zero for no limit.
+    size_t deadlineCountdown;      // Allocations until the clock is read again.
+    jmp_buf *escape;               // Where to go when a budget is exceeded.
+    JSDTidyArenaBudget exceededBudget;  // The budget that was exceeded, if any.
+} JSDTidyArena;
+
+
+/** The default value for an arena's @c limit. */
+#define JSDTidyArenaDefaultLimit ((size_t)256 * 1024 * 1024)
+
+
+/**
+ *  Prepares an arena for use. No memory is reserved until the first
+ *  allocation.
+ *
+ *  @param arena The arena to initialize.
+ *  @param limit The number of bytes that the arena may reserve in chunks
+ *    before falling back to @c malloc.
+ */
+void JSDTidyArenaInit( JSDTidyArena *arena, size_t limit );
+
+/**
+ *  Releases every allocation made since the last reset in one step and
+ *  zeroes the statistics. The first chunk is kept for reuse.
+ */
+void JSDTidyArenaReset( JSDTidyArena *arena );
+
+/**
+ *  Releases all memory held by the arena.
+ */
+void JSDTidyArenaDestroy( JSDTidyArena *arena );
+
+/**
+ *  Sets the budgets for the work done with the arena. While @c escape is
+ *  set, an allocation that would exceed a budget, or a call to
+ *  @c JSDTidyArenaCheckBudgets() after the deadline, records the budget
+ *  in @c exceededBudget, clears @c escape, and @c longjmp()s to it.
+ *
+ *  Because every allocation a TidyDoc makes (including the TidyDoc
+ *  itself) comes from its arena, a TidyDoc that was escaped from is
+ *  disposed of simply by resetting the arena; it must not be passed to
+ *  @b libtidy again, not even to @c tidyRelease(). A reset also clears
+ *  the budgets.
+ *
+ *  The byte budget limits the memory the arena holds, that is, its
+ *  chunks plus its live fallback blocks, and is checked whenever it's
+ *  about to take more. Because freed chunk space isn't reclaimed until
+ *  a reset, this is usually more than @c liveBytes.
+ *
+ *  @param arena The arena.
+ *  @param bytes The most bytes the arena may hold at once, or zero.
+ *  @param allocations The most allocations that may be made, or zero.
+ *  @param deadline The @c JSDTidyMonotonicTime(), in nanoseconds, after
+ *    which to stop, or zero.
+ */
+void JSDTidyArenaSetBudgets( JSDTidyArena *arena, size_t bytes, size_t allocations, uint64_t deadline );
+
+/**
+ *  Sets or clears the @c jmp_buf to which an exceeded budget escapes.
+ *  Budgets are only enforced while one is set, and it must be cleared
+ *  before the function that called @c setjmp() returns.
+ */
+void JSDTidyArenaSetEscape( JSDTidyArena *arena, jmp_buf *escape );
+
+/**
+ *  Escapes if the arena's deadline has passed. Allocations check the
+ *  deadline periodically on their own; call this from other places that
+ *  @b libtidy calls back regularly, such as the input source.
+ */
+void JSDTidyArenaCheckBudgets( JSDTidyArena *arena );
@@ -0,0 +1,521 @@
+//
+//  JSDTidyArena.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyArena.h"
+#import "JSDTidyPlatform.h"
+
+
+#pragma mark - Definitions
+
+
+/* Every block is preceded by a header, and every header ends with the
+ * block's size and a tag, so that free and realloc can tell chunk blocks
+ * from fallback blocks. Headers keep blocks 16-byte aligned.
+ */
+
+#define JSDArenaAlignment      ((size_t)16)
+#define JSDArenaFirstChunkSize ((size_t)256 * 1024)
+#define JSDArenaMaxChunkSize   ((size_t)4 * 1024 * 1024)
+
+#define JSDArenaDeadlineInterval ((size_t)256)  // Allocations between clock reads.
+
+#define JSDArenaTagChunk       ((size_t)0x41524e41)  // 'ARNA'
+#define JSDArenaTagFallback    ((size_t)0x46424c4b)  // 'FBLK'
+
+typedef struct JSDTidyArenaChunk {
+    struct JSDTidyArenaChunk *next;
+    size_t size;                   // Usable bytes following this header.
+    size_t used;                   // Bytes handed out so far.
+    size_t pad;
+} JSDTidyArenaChunk;
+
+typedef struct JSDTidyArenaBlock {
+    size_t size;
+    size_t tag;
+} JSDTidyArenaBlock;
+
+typedef struct JSDTidyArenaFallback {
+    struct JSDTidyArenaFallback *next;
+    struct JSDTidyArenaFallback *prev;
+    JSDTidyArenaBlock block;
+} JSDTidyArenaFallback;
+
+
+static inline size_t JSDArenaRound( size_t size )
+{
+    return (size + JSDArenaAlignment - 1) & ~(JSDArenaAlignment - 1);
+}
+
+static inline JSDTidyArenaBlock *JSDArenaBlockFor( void *ptr )
+{
+    return ((JSDTidyArenaBlock *)ptr) - 1;
+}
+
+static inline JSDTidyArenaFallback *JSDArenaFallbackFor( void *ptr )
+{
+    return (JSDTidyArenaFallback *)((char *)ptr - sizeof(JSDTidyArenaFallback));
+}
+
+static inline void JSDArenaCountLive( JSDTidyArena *arena, size_t added, size_t removed )
+{
+    arena->liveBytes = arena->liveBytes + added - removed;
+
+    if (arena->liveBytes > arena->peakBytes)
+    {
+        arena->peakBytes = arena->liveBytes;
+    }
+}
+
+
+#pragma mark - Budgets
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaEscape
+ *   Leaves libtidy for good; see JSDTidyArenaSetBudgets().
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void JSDArenaEscape( JSDTidyArena *arena, JSDTidyArenaBudget budget )
+{
+    jmp_buf *escape = arena->escape;
+
+    arena->escape = NULL;
+    arena->exceededBudget = budget;
+
+    longjmp(*escape, 1);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaCheckAllocation
+ *   Called before an allocation changes any of the arena's state,
+ *   so that escaping leaves it consistent. `growth` is the number
+ *   of bytes the arena must take from malloc to satisfy it, which
+ *   is zero when it fits in the current chunk.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline void JSDArenaCheckAllocation( JSDTidyArena *arena, size_t growth )
+{
+    if (!arena->escape)
+    {
+        return;
+    }
+
+    if (arena->byteBudget && growth && arena->reservedBytes + arena->fallbackBytes + growth > arena->byteBudget)
+    {
+        JSDArenaEscape(arena, JSDTidyArenaBudgetBytes);
+    }
+
+    if (arena->allocationBudget && arena->allocationCount >= arena->allocationBudget)
+    {
+        JSDArenaEscape(arena, JSDTidyArenaBudgetAllocations);
+    }
+
+    if (arena->deadline && arena->deadlineCountdown-- == 0)
+    {
+        arena->deadlineCountdown = JSDArenaDeadlineInterval;
+
+        JSDTidyArenaCheckBudgets(arena);
+    }
+}
+
+
+#pragma mark - Fallback Allocations
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaFallbackLink
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void JSDArenaFallbackLink( JSDTidyArena *arena, JSDTidyArenaFallback *fallback )
+{
+    fallback->prev = NULL;
+    fallback->next = arena->fallbacks;
+
+    if (arena->fallbacks)
+    {
+        arena->fallbacks->prev = fallback;
+    }
+
+    arena->fallbacks = fallback;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaFallbackAlloc
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void *JSDArenaFallbackAlloc( JSDTidyArena *arena, size_t size )
+{
+    JSDTidyArenaFallback *fallback = malloc(sizeof(JSDTidyArenaFallback) + size);
+
+    if (!fallback)
+    {
+        return NULL;
+    }
+
+    fallback->block.size = size;
+    fallback->block.tag = JSDArenaTagFallback;
+
+    JSDArenaFallbackLink(arena, fallback);
+    JSDArenaCountLive(arena, size, 0);
+
+    arena->fallbackBytes += size;
+    arena->fallbackCount++;
+
+    return fallback + 1;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaFallbackUnlink
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void JSDArenaFallbackUnlink( JSDTidyArena *arena, JSDTidyArenaFallback *fallback )
+{
+    if (fallback->prev)
+    {
+        fallback->prev->next = fallback->next;
+    }
+    else
+    {
+        arena->fallbacks = fallback->next;
+    }
+
+    if (fallback->next)
+    {
+        fallback->next->prev = fallback->prev;
+    }
+}
+
+
+#pragma mark - TidyAllocator Implementation
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaNextChunkSize
+ *   The size of the chunk to add when the current one is full.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline size_t JSDArenaNextChunkSize( JSDTidyArena *arena )
+{
+    JSDTidyArenaChunk *chunk = arena->chunks;
+
+    return chunk ? MIN(chunk->size * 2, JSDArenaMaxChunkSize) : JSDArenaFirstChunkSize;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaAlloc
+ *   Bump-allocates from the current chunk, adding a new chunk if
+ *   there's room under the limit, and falling back to malloc if
+ *   there isn't, or if the request is large.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void *TIDY_CALL JSDArenaAlloc( TidyAllocator *base, size_t size )
+{
+    JSDTidyArena *arena = (JSDTidyArena *)base;
+    size_t rounded = JSDArenaRound(size ? size : 1);
+    size_t needed = rounded + sizeof(JSDTidyArenaBlock);
+    BOOL isLarge = needed > JSDArenaMaxChunkSize / 4;
+    JSDTidyArenaChunk *chunk = arena->chunks;
+    BOOL isFull = !chunk || (chunk->size - chunk->used < needed);
+    size_t chunkSize = JSDArenaNextChunkSize(arena);
+    BOOL isOverLimit = arena->reservedBytes + chunkSize > arena->limit;
+
+    /* Only a new chunk or a fallback takes more memory. */
+    size_t growth = 0;
+
+    if (isLarge || (isFull && isOverLimit))
+    {
+        growth = size;
+    }
+    else if (isFull)
+    {
+        growth = chunkSize;
+    }
+
+    JSDArenaCheckAllocation(arena, growth);
+
+    arena->allocationCount++;
+
+    if (isLarge)
+    {
+        return JSDArenaFallbackAlloc(arena, size);
+    }
+
+    if (isFull)
+    {
+        if (isOverLimit)
+        {
+            return JSDArenaFallbackAlloc(arena, size);
+        }
+
+        JSDTidyArenaChunk *newChunk = malloc(sizeof(JSDTidyArenaChunk) + chunkSize);
+
+        if (!newChunk)
+        {
+            return JSDArenaFallbackAlloc(arena, size);
+        }
+
+        newChunk->next = chunk;
+        newChunk->size = chunkSize;
+        newChunk->used = 0;
+
+        arena->chunks = newChunk;
+        arena->reservedBytes += chunkSize;
+
+        chunk = newChunk;
+    }
+
+    JSDTidyArenaBlock *block = (JSDTidyArenaBlock *)((char *)(chunk + 1) + chunk->used);
+
+    block->size = rounded;
+    block->tag = JSDArenaTagChunk;
+
+    chunk->used += needed;
+
+    JSDArenaCountLive(arena, rounded, 0);
+
+    return block + 1;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaFree
+ *   Chunk blocks are reclaimed by the next reset; the only thing
+ *   we can cheaply do is roll back the most recent allocation.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void TIDY_CALL JSDArenaFree( TidyAllocator *base, void *ptr )
+{
+    JSDTidyArena *arena = (JSDTidyArena *)base;
+
+    if (!ptr)
+    {
+        return;
+    }
+
+    JSDTidyArenaBlock *block = JSDArenaBlockFor(ptr);
+
+    if (block->tag == JSDArenaTagFallback)
+    {
+        JSDTidyArenaFallback *fallback = JSDArenaFallbackFor(ptr);
+
+        JSDArenaCountLive(arena, 0, fallback->block.size);
+        arena->fallbackBytes -= fallback->block.size;
+        JSDArenaFallbackUnlink(arena, fallback);
+        free(fallback);
+        return;
+    }
+
+    JSDTidyArenaChunk *chunk = arena->chunks;
+
+    JSDArenaCountLive(arena, 0, block->size);
+
+    if ((char *)ptr + block->size == (char *)(chunk + 1) + chunk->used)
+    {
+        chunk->used -= block->size + sizeof(JSDTidyArenaBlock);
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaRealloc
+ *   Grows the most recent chunk allocation in place when possible;
+ *   otherwise allocates anew and copies.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void *TIDY_CALL JSDArenaRealloc( TidyAllocator *base, void *ptr, size_t size )
+{
+    JSDTidyArena *arena = (JSDTidyArena *)base;
+
+    if (!ptr)
+    {
+        return JSDArenaAlloc(base, size);
+    }
+
+    JSDTidyArenaBlock *block = JSDArenaBlockFor(ptr);
+
+    if (block->tag == JSDArenaTagFallback)
+    {
+        JSDTidyArenaFallback *fallback = JSDArenaFallbackFor(ptr);
+        size_t oldSize = fallback->block.size;
+
+        JSDArenaCheckAllocation(arena, size > oldSize ? size - oldSize : 0);
+
+        JSDArenaFallbackUnlink(arena, fallback);
+
+        JSDTidyArenaFallback *moved = realloc(fallback, sizeof(JSDTidyArenaFallback) + size);
+
+        if (!moved)
+        {
+            /* The original block is still valid, so keep tracking it. */
+            JSDArenaFallbackLink(arena, fallback);
+            return NULL;
+        }
+
+        moved->block.size = size;
+        JSDArenaFallbackLink(arena, moved);
+        JSDArenaCountLive(arena, size, oldSize);
+
+        arena->fallbackBytes = arena->fallbackBytes + size - oldSize;
+
+        return moved + 1;
+    }
+
+    size_t rounded = JSDArenaRound(size ? size : 1);
+    JSDTidyArenaChunk *chunk = arena->chunks;
+    char *chunkEnd = (char *)(chunk + 1) + chunk->used;
+
+    /* Shrinking, or the block already has room. */
+    if (rounded <= block->size)
+    {
+        return ptr;
+    }
+
+    /* The most recent allocation can grow in place. */
+    if (((char *)ptr + block->size == chunkEnd) && (chunk->size - chunk->used >= rounded - block->size))
+    {
+        JSDArenaCheckAllocation(arena, 0);
+
+        JSDArenaCountLive(arena, rounded - block->size, 0);
+        chunk->used += rounded - block->size;
+        block->size = rounded;
+        return ptr;
+    }
+
+    size_t oldSize = block->size;
+    void *result = JSDArenaAlloc(base, size);
+
+    if (result)
+    {
+        memcpy(result, ptr, oldSize);
+        JSDArenaFree(base, ptr);
+    }
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDArenaPanic
+ *   libtidy calls this if an allocation fails. Like libtidy's own
+ *   default allocator, there's no recovering from this.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void TIDY_CALL JSDArenaPanic( TidyAllocator *base, ctmbstr msg )
+{
+    NSLog(@"JSDTidyArena: libtidy panic: %s", msg);
+    abort();
+}
+
+
+static const TidyAllocatorVtbl JSDTidyArenaVtbl = {
+    JSDArenaAlloc,
+    JSDArenaRealloc,
+    JSDArenaFree,
+    JSDArenaPanic
+};
+
+
+#pragma mark - Public Functions
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyArenaInit
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+void JSDTidyArenaInit( JSDTidyArena *arena, size_t limit )
+{
+    memset(arena, 0, sizeof(JSDTidyArena));
+
+    arena->allocator.vtbl = &JSDTidyArenaVtbl;
+    arena->limit = limit;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyArenaReset
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+void JSDTidyArenaReset( JSDTidyArena *arena )
+{
+    while (arena->fallbacks)
+    {
+        JSDTidyArenaFallback *next = arena->fallbacks->next;
+        free(arena->fallbacks);
+        arena->fallbacks = next;
+    }
+
+    /* Keep only the oldest (first, smallest) chunk. */
+    JSDTidyArenaChunk *chunk = arena->chunks;
+
+    while (chunk && chunk->next)
+    {
+        JSDTidyArenaChunk *next = chunk->next;
+        arena->reservedBytes -= chunk->size;
+        free(chunk);
+        chunk = next;
+    }
+
+    if (chunk)
+    {
+        chunk->used = 0;
+    }
+
+    arena->chunks = chunk;
+    arena->fallbackBytes = 0;
+    arena->liveBytes = 0;
+    arena->peakBytes = 0;
+    arena->allocationCount = 0;
+    arena->fallbackCount = 0;
+
+    arena->byteBudget = 0;
+    arena->allocationBudget = 0;
+    arena->deadline = 0;
+    arena->escape = NULL;
+    arena->exceededBudget = JSDTidyArenaBudgetNone;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyArenaDestroy
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+void JSDTidyArenaDestroy( JSDTidyArena *arena )
+{
+    JSDTidyArenaReset(arena);
+
+    if (arena->chunks)
+    {
+        free(arena->chunks);
+    }
+
+    arena->chunks = NULL;
+    arena->reservedBytes = 0;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyArenaSetBudgets
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+void JSDTidyArenaSetBudgets( JSDTidyArena *arena, size_t bytes, size_t allocations, uint64_t deadline )
+{
+    arena->byteBudget = bytes;
+    arena->allocationBudget = allocations;
+    arena->deadline = deadline;
+    arena->deadlineCountdown = JSDArenaDeadlineInterval;
+    arena->exceededBudget = JSDTidyArenaBudgetNone;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyArenaSetEscape
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+void JSDTidyArenaSetEscape( JSDTidyArena *arena, jmp_buf *escape )
+{
+    arena->escape = escape;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyArenaCheckBudgets
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+void JSDTidyArenaCheckBudgets( JSDTidyArena *arena )
+{
+    if (arena->escape && arena->deadline && JSDTidyMonotonicTime() > arena->deadline)
+    {
+        JSDArenaEscape(arena, JSDTidyArenaBudgetTime);
+    }
+}
@@ -0,0 +1,226 @@
+//
+//  JSDTidyBatchProcessor.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+@import HTMLTidy;
+
+#import <JSDTidyFramework/JSDTidyModel.h>
+
+@class JSDTidyOptionSet;
+@class JSDTidyResultCache;
+
+
+#pragma mark - class JSDTidyBatchResult
+
+
+/**
+ *  The result of tidying one input of a @c JSDTidyBatchProcessor. The
+ *  properties have the same meanings as the like-named properties of
+ *  @c JSDTidyModel.
+ */
+@interface JSDTidyBatchResult : NSObject
+
+/**
+ *  The index of the input in the array that was given to the processor.
+ */
+@property (nonatomic, assign, readonly) NSUInteger index;
+
+/**
+ *  The file that was tidied, or @c nil if the input was data.
+ */
+@property (nonatomic, strong, readonly) NSURL *fileURL;
+
+/**
+ *  If the input couldn't be read, or couldn't be decoded with the
+ *  @b input-encoding, the reason; otherwise @c nil. Such inputs aren't
+ *  tidied, and their @c tidyStatus is -1.
+ */
+@property (nonatomic, strong, readonly) NSError *error;
+
+/**
+ *  The number of bytes in the input.
+ */
+@property (nonatomic, assign, readonly) NSUInteger sourceByteCount;
+
+/**
+ *  The time that it took to read and tidy the input, in seconds.
+ */
+@property (nonatomic, assign, readonly) NSTimeInterval elapsedTime;
+
+/**
+ *  The tidy text as UTF-8 data with LF line endings.
+ */
+@property (nonatomic, strong, readonly) NSData *tidyTextAsUTF8Data;
+
+/**
+ *  The tidy text. This is decoded from @c tidyTextAsUTF8Data when it's
+ *  first read.
+ */
+@property (nonatomic, strong, readonly) NSString *tidyText;
+
+/**
+ *  The tidy text in the processor's @b output-encoding, with the line
+ *  endings given by its @b newline option; suitable for writing to a file.
+ */
+@property (nonatomic, strong, readonly) NSData *tidyTextAsData;
+
+@property (nonatomic, strong, readonly) NSString *errorText;
+
+@property (nonatomic, strong, readonly) NSArray *errorArray;
+
+@property (nonatomic, assign, readonly) int tidyDetectedHtmlVersion;
+
+@property (nonatomic, assign, readonly) bool tidyDetectedXhtml;
+
+@property (nonatomic, assign, readonly) bool tidyDetectedGenericXml;
+
+@property (nonatomic, assign, readonly) int tidyStatus;
+
+@property (nonatomic, assign, readonly) uint tidyErrorCount;
+
+@property (nonatomic, assign, readonly) uint tidyWarningCount;
+
+@property (nonatomic, assign, readonly) uint tidyAccessWarningCount;
+
+@property (nonatomic, assign, readonly) BOOL tidyResultWasCached;
+
+@property (nonatomic, assign, readonly) BOOL tidyStoppedEarly;
+
+@property (nonatomic, assign, readonly) JSDTidyBudgetStatus tidyBudgetStatus;
+
+@end
+
+
+/**
+ *  The block type used by @c JSDTidyBatchProcessor to deliver results.
+ *  It's called on the worker thread that tidied the input, so it must be
+ *  safe to call concurrently.
+ */
+typedef void (^JSDTidyBatchResultHandler)(JSDTidyBatchResult *result);
+
+
+#pragma mark - class JSDTidyBatchProcessor
+
+
+/**
+ *  @c JSDTidyBatchProcessor tidies many documents at once, for command
+ *  line tools, lint passes, and other work over large sets of files.
+ *
+ *  Unlike @c JSDTidyModel, it has no KVO, no notifications, and no
+ *  delegate. The inputs are spread over a pool of worker threads, one per
+ *  processor core by default. Each worker starts with an equal share of
+ *  the inputs, and a worker that runs out steals half of the remaining
+ *  inputs of another, so that a few large documents don't leave the other
+ *  cores idle. Each worker has a TidyDoc of its own, which is reused for
+ *  every input that it tidies.
+ *
+ *  The configuration properties must not be changed while a batch is
+ *  being processed.
+ */
+@interface JSDTidyBatchProcessor : NSObject
+
+
+#pragma mark - Creating Processors
+
+
+/**
+ *  Initializes a processor that tidies with @c optionSet.
+ *
+ *  @param optionSet The options to tidy with. The @b input-encoding
+ *    option determines how inputs are decoded.
+ */
+- (instancetype)initWithOptionSet:(JSDTidyOptionSet *)optionSet NS_DESIGNATED_INITIALIZER;
+
+/**
+ *  The options that inputs are tidied with.
+ */
+@property (nonatomic, strong, readonly) JSDTidyOptionSet *optionSet;
+
+
+#pragma mark - Configuration
+
+
+/**
+ *  The number of worker threads. The default is the number of active
+ *  processor cores.
+ */
+@property (nonatomic, assign) NSUInteger workerCount;
+
+/**
+ *  How much of its work each run does; see @c [JSDTidyModel @c runMode].
+ *  @c JSDTidyRunModeDeferredOutput is the same as
+ *  @c JSDTidyRunModeComplete here, because results are delivered as soon
+ *  as they're made. The default is @c JSDTidyRunModeComplete.
+ */
+@property (nonatomic, assign) JSDTidyRunMode runMode;
+
+/**
+ *  See @c [JSDTidyModel @c stopAfterReportCount]. The default is zero.
+ */
+@property (nonatomic, assign) NSUInteger stopAfterReportCount;
+
+/**
+ *  See @c [JSDTidyModel @c stopAtReportLevel]. The default is
+ *  @c TidyError.
+ */
+@property (nonatomic, assign) TidyReportLevel stopAtReportLevel;
+
+/**
+ *  See @c [JSDTidyModel @c timeBudget]. The budget applies to each input.
+ *  The default is zero.
+ */
+@property (nonatomic, assign) NSTimeInterval timeBudget;
+
+/**
+ *  See @c [JSDTidyModel @c allocationBudget]. The default is zero.
+ */
+@property (nonatomic, assign) NSUInteger allocationBudget;
+
+/**
+ *  See @c [JSDTidyModel @c memoryBudget]. The budget applies to each
+ *  input. The default is zero.
+ */
+@property (nonatomic, assign) NSUInteger memoryBudget;
+
+/**
+ *  The cache that is consulted before each input is tidied, and that
+ *  receives the results. The default is @c nil, because the inputs of a
+ *  batch are seldom tidied twice; use a cache with a
+ *  @c persistentStoreURL to speed up repeated passes over the same files.
+ */
+@property (nonatomic, strong) JSDTidyResultCache *resultCache;
+
+
+#pragma mark - Processing
+
+
+/**
+ *  Tidies each of the files, and returns when all of them are done. The
+ *  files are memory mapped rather than read.
+ *
+ *  @param fileURLs The files to tidy.
+ *  @param resultHandler Called once for each file, in no particular order.
+ */
+- (void)processFileURLs:(NSArray<NSURL *> *)fileURLs resultHandler:(JSDTidyBatchResultHandler)resultHandler;
+
+/**
+ *  Tidies each of the buffers, and returns when all of them are done.
+ *
+ *  @param dataArray The documents to tidy.
+ *  @param resultHandler Called once for each buffer, in no particular order.
+ */
+- (void)processData:(NSArray<NSData *> *)dataArray resultHandler:(JSDTidyBatchResultHandler)resultHandler;
+
+/**
+ *  Stops the batch that is being processed. Inputs that are already being
+ *  tidied are finished; no others are started, and they get no results.
+ *  This may be called from any thread, including from a result handler.
+ */
+- (void)cancel;
+
+
+@end
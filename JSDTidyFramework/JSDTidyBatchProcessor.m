@@ -0,0 +1,506 @@
+//
+//  JSDTidyBatchProcessor.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyBatchProcessor.h"
+
+#import "JSDTidyOptionSet.h"
+#import "JSDTidyRun.h"
+#import "JSDTidyTranscoder.h"
+#import "JSDTidyPlatform.h"
+
+#include <stdatomic.h>
+#include <time.h>
+
+
+#pragma mark - Definitions
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyBatchQueue
+ *   A worker's share of the inputs, as the range of indexes from
+ *   `next` to `end`. The owner takes from the front, and thieves
+ *   take the back half, so the two rarely want the same input.
+ *   Each queue is aligned to, and so fills, whole cache lines, as
+ *   long as the array of queues is allocated with that alignment.
+ *   Apple silicon's lines are 128 bytes.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+#define JSDTidyBatchQueueAlignment ((size_t)128)
+
+typedef struct JSDTidyBatchQueue {
+    _Alignas(JSDTidyBatchQueueAlignment) JSDTidyLock lock;
+    NSUInteger next;
+    NSUInteger end;
+} JSDTidyBatchQueue;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyBatchQueueTake
+ *   Takes the next input from the front of the queue, returning
+ *   NSNotFound if it's empty.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSUInteger JSDTidyBatchQueueTake( JSDTidyBatchQueue *queue )
+{
+    NSUInteger index = NSNotFound;
+
+    JSDTidyLockLock(&queue->lock);
+
+    if (queue->next < queue->end)
+    {
+        index = queue->next++;
+    }
+
+    JSDTidyLockUnlock(&queue->lock);
+
+    return index;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyBatchQueueSteal
+ *   Moves the back half of the first non-empty victim's inputs to
+ *   `thief`, which must be empty. Returns NO if every queue is.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static BOOL JSDTidyBatchQueueSteal( JSDTidyBatchQueue *queues, NSUInteger count, NSUInteger thief )
+{
+    for (NSUInteger i = 1; i < count; i++)
+    {
+        JSDTidyBatchQueue *victim = &queues[(thief + i) % count];
+
+        NSUInteger begin = 0;
+        NSUInteger end = 0;
+
+        JSDTidyLockLock(&victim->lock);
+
+        if (victim->next < victim->end)
+        {
+            NSUInteger remaining = victim->end - victim->next;
+
+            begin = victim->next + remaining / 2;
+            end = victim->end;
+
+            victim->end = begin;
+        }
+
+        JSDTidyLockUnlock(&victim->lock);
+
+        if (begin < end)
+        {
+            JSDTidyLockLock(&queues[thief].lock);
+
+            queues[thief].next = begin;
+            queues[thief].end = end;
+
+            JSDTidyLockUnlock(&queues[thief].lock);
+
+            return YES;
+        }
+    }
+
+    return NO;
+}
+
+
+#pragma mark - CATEGORY JSDTidyBatchResult ()
+
+
+@interface JSDTidyBatchResult ()
+
+@property (nonatomic, assign, readwrite) NSUInteger index;
+
+@property (nonatomic, strong, readwrite) NSURL *fileURL;
+
+@property (nonatomic, strong, readwrite) NSError *error;
+
+@property (nonatomic, assign, readwrite) NSUInteger sourceByteCount;
+
+@property (nonatomic, assign, readwrite) NSTimeInterval elapsedTime;
+
+@property (nonatomic, strong, readwrite) NSData *tidyTextAsUTF8Data;
+
+@property (nonatomic, strong, readwrite) NSString *errorText;
+
+@property (nonatomic, strong, readwrite) NSArray *errorArray;
+
+@property (nonatomic, assign, readwrite) int tidyDetectedHtmlVersion;
+
+@property (nonatomic, assign, readwrite) bool tidyDetectedXhtml;
+
+@property (nonatomic, assign, readwrite) bool tidyDetectedGenericXml;
+
+@property (nonatomic, assign, readwrite) int tidyStatus;
+
+@property (nonatomic, assign, readwrite) uint tidyErrorCount;
+
+@property (nonatomic, assign, readwrite) uint tidyWarningCount;
+
+@property (nonatomic, assign, readwrite) uint tidyAccessWarningCount;
+
+@property (nonatomic, assign, readwrite) BOOL tidyResultWasCached;
+
+@property (nonatomic, assign, readwrite) BOOL tidyStoppedEarly;
+
+@property (nonatomic, assign, readwrite) JSDTidyBudgetStatus tidyBudgetStatus;
+
+@property (nonatomic, assign) NSStringEncoding outputEncoding;
+
+@property (nonatomic, assign) TidyLineEnding outputLineEnding;
+
+@end
+
+
+#pragma mark - IMPLEMENTATION JSDTidyBatchResult
+
+
+@implementation JSDTidyBatchResult
+{
+    JSDTidyLock _lock;
+    NSString *_tidyText;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - init
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)init
+{
+    if (self = [super init])
+    {
+        _lock               = JSDTidyLockInit;
+        _tidyTextAsUTF8Data = [[NSData alloc] init];
+        _errorText          = @"";
+        _errorArray         = @[];
+        _outputEncoding     = NSUTF8StringEncoding;
+        _outputLineEnding   = TidyLF;
+    }
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @tidyText
+ *   Results can be handed to other threads, so building the string
+ *   is locked.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)tidyText
+{
+    JSDTidyLockLock(&_lock);
+
+    if (!_tidyText)
+    {
+        _tidyText = [[NSString alloc] initWithData:_tidyTextAsUTF8Data encoding:NSUTF8StringEncoding];
+
+        if (!_tidyText)
+        {
+            _tidyText = @"";
+        }
+    }
+
+    NSString *tidyText = _tidyText;
+
+    JSDTidyLockUnlock(&_lock);
+
+    return tidyText;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @tidyTextAsData
+ *   The same conversion as JSDTidyModel's.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSData *)tidyTextAsData
+{
+    NSStringEncoding encoding = self.outputEncoding;
+    TidyLineEnding lineEnding = self.outputLineEnding;
+    NSData *utf8Data = self.tidyTextAsUTF8Data;
+
+    if (encoding == NSUTF8StringEncoding && lineEnding == TidyLF)
+    {
+        return utf8Data;
+    }
+
+    if (JSDTidyTranscoderSupportsEncoding(encoding))
+    {
+        return JSDTidyTranscodeUTF8(utf8Data.bytes, utf8Data.length, encoding, lineEnding);
+    }
+
+    if (lineEnding == TidyLF)
+    {
+        return [self.tidyText dataUsingEncoding:encoding];
+    }
+
+    NSData *expanded = JSDTidyTranscodeUTF8(utf8Data.bytes, utf8Data.length, NSUTF8StringEncoding, lineEnding);
+    NSString *expandedText = [[NSString alloc] initWithData:expanded encoding:NSUTF8StringEncoding];
+
+    return [expandedText dataUsingEncoding:encoding];
+}
+
+
+@end
+
+
+#pragma mark - IMPLEMENTATION JSDTidyBatchProcessor
+
+
+@implementation JSDTidyBatchProcessor
+{
+    atomic_bool _cancelled;
+}
+
+
+#pragma mark - Initialization
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - init
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)init
+{
+    return [self initWithOptionSet:[JSDTidyOptionSet optionSetWithBuiltInDefaults]];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithOptionSet:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithOptionSet:(JSDTidyOptionSet *)optionSet
+{
+    if (self = [super init])
+    {
+        _optionSet            = optionSet;
+        _workerCount          = [[NSProcessInfo processInfo] activeProcessorCount];
+        _runMode              = JSDTidyRunModeComplete;
+        _stopAfterReportCount = 0;
+        _stopAtReportLevel    = TidyError;
+        _timeBudget           = 0;
+        _allocationBudget     = 0;
+        _memoryBudget         = 0;
+        _resultCache          = nil;
+
+        atomic_init(&_cancelled, false);
+    }
+
+    return self;
+}
+
+
+#pragma mark - Processing
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - processFileURLs:resultHandler:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)processFileURLs:(NSArray<NSURL *> *)fileURLs resultHandler:(JSDTidyBatchResultHandler)resultHandler
+{
+    [self processInputs:fileURLs resultHandler:resultHandler];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - processData:resultHandler:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)processData:(NSArray<NSData *> *)dataArray resultHandler:(JSDTidyBatchResultHandler)resultHandler
+{
+    [self processInputs:dataArray resultHandler:resultHandler];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - cancel
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)cancel
+{
+    atomic_store(&_cancelled, true);
+}
+
+
+#pragma mark - Private
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - processInputs:resultHandler: (private)
+ *    Each worker starts with an equal, contiguous share of the
+ *    inputs, and steals from the others when its own run out.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)processInputs:(NSArray *)inputs resultHandler:(JSDTidyBatchResultHandler)resultHandler
+{
+    NSUInteger inputCount = inputs.count;
+    NSUInteger workerCount = MAX(1, MIN(self.workerCount, inputCount));
+
+    if (inputCount == 0)
+    {
+        return;
+    }
+
+    atomic_store(&_cancelled, false);
+
+    JSDTidyBatchQueue *queues = NULL;
+
+    if (posix_memalign((void **)&queues, JSDTidyBatchQueueAlignment, workerCount * sizeof(JSDTidyBatchQueue)) != 0)
+    {
+        return;
+    }
+
+    for (NSUInteger i = 0; i < workerCount; i++)
+    {
+        queues[i].lock = JSDTidyLockInit;
+        queues[i].next = inputCount * i / workerCount;
+        queues[i].end  = inputCount * (i + 1) / workerCount;
+    }
+
+    dispatch_apply(workerCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t worker) {
+
+        JSDTidyDocPool *pool = [[JSDTidyDocPool alloc] init];
+
+        /* Each worker copies its TidyDocs' options from a template of its
+         * own, so the workers share nothing but the queues.
+         */
+        TidyDoc templateDoc = tidyCreate();
+
+        [self.optionSet applyToTidyDoc:templateDoc];
+
+        while (!atomic_load(&self->_cancelled))
+        {
+            NSUInteger index = JSDTidyBatchQueueTake(&queues[worker]);
+
+            if (index == NSNotFound)
+            {
+                if (!JSDTidyBatchQueueSteal(queues, workerCount, worker))
+                {
+                    break;
+                }
+
+                continue;
+            }
+
+            @autoreleasepool
+            {
+                JSDTidyBatchResult *result = [self resultForInput:inputs[index] index:index pool:pool templateDoc:templateDoc];
+
+                if (resultHandler)
+                {
+                    resultHandler(result);
+                }
+            }
+        }
+
+        tidyRelease(templateDoc);
+    });
+
+    free(queues);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - resultForInput:index:pool:templateDoc: (private)
+ *    UTF-8 inputs are parsed straight from their bytes; anything
+ *    else is decoded first, just as JSDTidyModel does.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyBatchResult *)resultForInput:(id)input index:(NSUInteger)index pool:(JSDTidyDocPool *)pool templateDoc:(TidyDoc)templateDoc
+{
+    uint64_t start = JSDTidyMonotonicTime();
+
+    JSDTidyBatchResult *result = [[JSDTidyBatchResult alloc] init];
+
+    result.index = index;
+
+    NSStringEncoding outputEncoding = [[self.optionSet valueForOptionName:@"output-encoding"] integerValue];
+
+    result.outputEncoding   = outputEncoding ?: NSUTF8StringEncoding;
+    result.outputLineEnding = (TidyLineEnding)[[self.optionSet valueForOptionName:@"newline"] integerValue];
+
+    NSData *data = input;
+
+    if ([input isKindOfClass:[NSURL class]])
+    {
+        NSError *error = nil;
+
+        result.fileURL = input;
+
+        /* Not mapped: a file that's truncated or rewritten while it's
+         * being tidied would crash the whole batch with SIGBUS.
+         */
+        data = [NSData dataWithContentsOfURL:input options:0 error:&error];
+
+        if (!data)
+        {
+            result.error = error;
+            result.tidyStatus = -1;
+            result.elapsedTime = (double)(JSDTidyMonotonicTime() - start) / NSEC_PER_SEC;
+            return result;
+        }
+    }
+
+    result.sourceByteCount = data.length;
+
+    JSDTidyRun *run = [[JSDTidyRun alloc] init];
+
+    NSStringEncoding encoding = [[self.optionSet valueForOptionName:@"input-encoding"] integerValue];
+
+    if (encoding == 0 || encoding == NSUTF8StringEncoding)
+    {
+        run.sourceData = data;
+    }
+    else
+    {
+        run.sourceText = [[NSString alloc] initWithData:data encoding:encoding];
+
+        /* Tidying an empty document instead would report success, and
+         * could replace the file with an empty skeleton.
+         */
+        if (!run.sourceText)
+        {
+            NSMutableDictionary *userInfo = [[NSMutableDictionary alloc] init];
+
+            userInfo[NSStringEncodingErrorKey] = @(encoding);
+            userInfo[NSURLErrorKey] = result.fileURL;
+
+            result.error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadInapplicableStringEncodingError userInfo:userInfo];
+            result.tidyStatus = -1;
+            result.elapsedTime = (double)(JSDTidyMonotonicTime() - start) / NSEC_PER_SEC;
+            return result;
+        }
+    }
+
+    JSDTidyDocEntry *entry = [pool checkOut];
+
+    tidyOptCopyConfig( entry->tidyDoc, templateDoc );
+
+    run.entry   = entry;
+    run.pool    = pool;
+    run.cache   = self.resultCache;
+    run.options = self.optionSet;
+    run.runMode = self.runMode == JSDTidyRunModeDiagnosticsOnly ? JSDTidyRunModeDiagnosticsOnly : JSDTidyRunModeComplete;
+
+    run.stopAfterReportCount = self.stopAfterReportCount;
+    run.stopAtReportLevel    = self.stopAtReportLevel;
+    run.timeBudget           = self.timeBudget;
+    run.allocationBudget     = self.allocationBudget;
+    run.memoryBudget         = self.memoryBudget;
+
+    [run execute];
+
+    result.tidyTextAsUTF8Data      = run.tidyData;
+    result.errorText               = run.errorText;
+    result.errorArray              = run.errorArray;
+    result.tidyDetectedHtmlVersion = run.tidyDetectedHtmlVersion;
+    result.tidyDetectedXhtml       = run.tidyDetectedXhtml;
+    result.tidyDetectedGenericXml  = run.tidyDetectedGenericXml;
+    result.tidyStatus              = run.tidyStatus;
+    result.tidyErrorCount          = run.tidyErrorCount;
+    result.tidyWarningCount        = run.tidyWarningCount;
+    result.tidyAccessWarningCount  = run.tidyAccessWarningCount;
+    result.tidyResultWasCached     = run.resultWasCached;
+    result.tidyStoppedEarly        = run.stoppedEarly;
+    result.tidyBudgetStatus        = run.budgetStatus;
+    result.elapsedTime             = (double)(JSDTidyMonotonicTime() - start) / NSEC_PER_SEC;
+
+    return result;
+}
+
+
+@end
@@ -0,0 +1,113 @@
+//
+//  JSDTidyCachedResult.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+#import "JSDTidyResultCache.h"
+#import "JSDTidyMessageList.h"
+
+
+/**
+ *  Identifies the result of tidying one source with one set of options
+ *  with one version of @b libtidy.
+ */
+typedef struct JSDTidyResultKey {
+    uint64_t sourceHash;           // JSDTidyHashBytes of the UTF-8 source.
+    uint64_t sourceLength;         // Length of the UTF-8 source, in bytes.
+    uint64_t optionsFingerprint;   // [JSDTidyOptionSet fingerprint].
+    uint64_t libraryHash;          // JSDTidyLibraryHash().
+} JSDTidyResultKey;
+
+
+/**
+ *  A 64-bit hash of @c length bytes, using the XXH64 algorithm. It reads
+ *  the bytes a word at a time, so it's fast enough to use for every run,
+ *  and it's the same on every platform and from one launch to the next.
+ */
+uint64_t JSDTidyHashBytes( const void *bytes, size_t length, uint64_t seed );
+
+/**
+ *  A hash of @b libtidy's version and release date, so that results from
+ *  a different version of the library are never reused.
+ */
+uint64_t JSDTidyLibraryHash( void );
+
+/**
+ *  Makes the key for tidying @c bytes with the options that have
+ *  @c fingerprint.
+ */
+JSDTidyResultKey JSDTidyResultKeyMake( const void *bytes, size_t length, uint64_t fingerprint );
+
+
+/**
+ *  @c JSDTidyCachedResult holds everything that a run captures from
+ *  @b libtidy, so that the run can be satisfied from a
+ *  @c JSDTidyResultCache instead of parsing. Results are filled in once
+ *  and are immutable after they've been stored.
+ */
+@interface JSDTidyCachedResult : NSObject
+
+@property (nonatomic, assign) JSDTidyResultKey key;
+
+@property (nonatomic, strong) NSData *tidyData;
+
+@property (nonatomic, strong) NSString *errorText;
+
+@property (nonatomic, strong) JSDTidyMessageList *errorArray;
+
+@property (nonatomic, assign) int tidyDetectedHtmlVersion;
+
+@property (nonatomic, assign) bool tidyDetectedXhtml;
+
+@property (nonatomic, assign) bool tidyDetectedGenericXml;
+
+@property (nonatomic, assign) int tidyStatus;
+
+@property (nonatomic, assign) uint tidyErrorCount;
+
+@property (nonatomic, assign) uint tidyWarningCount;
+
+@property (nonatomic, assign) uint tidyAccessWarningCount;
+
+/**
+ *  The approximate number of bytes the result occupies, which is what is
+ *  counted against a cache's @c memoryLimit.
+ */
+@property (nonatomic, assign, readonly) NSUInteger cost;
+
+/* Maintained by JSDTidyResultCache for its recently used list; the
+ * cache's table owns the results.
+ */
+
+@property (nonatomic, unsafe_unretained) JSDTidyCachedResult *newer;
+
+@property (nonatomic, unsafe_unretained) JSDTidyCachedResult *older;
+
+@end
+
+
+/**
+ *  The methods that @c JSDTidyModel uses to look up and store results.
+ *  These are safe to call from any thread.
+ */
+@interface JSDTidyResultCache ()
+
+/**
+ *  Returns the result for @c key, marking it as the most recently used,
+ *  or @c nil if there isn't one. Either way, the hit and miss counts are
+ *  updated.
+ */
+- (JSDTidyCachedResult *)resultForKey:(JSDTidyResultKey)key;
+
+/**
+ *  Stores @c result under its key, evicting the least recently used
+ *  results as needed to stay within @c memoryLimit. Results that are too
+ *  large to fit are not stored at all.
+ */
+- (void)storeResult:(JSDTidyCachedResult *)result;
+
+@end
@@ -0,0 +1,187 @@
+//
+//  JSDTidyCachedResult.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyCachedResult.h"
+#import "JSDTidyPlatform.h"
+
+@import HTMLTidy;
+
+
+#pragma mark - Hashing
+
+
+#define JSDPrime1 0x9E3779B185EBCA87ULL
+#define JSDPrime2 0xC2B2AE3D27D4EB4FULL
+#define JSDPrime3 0x165667B19E3779F9ULL
+#define JSDPrime4 0x85EBCA77C2B2AE63ULL
+#define JSDPrime5 0x27D4EB2F165667C5ULL
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDRotate, JSDRead64, JSDRead32, JSDRound, JSDMergeRound
+ *   The building blocks of XXH64. Reads are done with memcpy,
+ *   which compiles to a single unaligned load.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline uint64_t JSDRotate( uint64_t value, int bits )
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t JSDRead64( const uint8_t *bytes )
+{
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return JSDTidyLittleToHost64(value);
+}
+
+static inline uint32_t JSDRead32( const uint8_t *bytes )
+{
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return JSDTidyLittleToHost32(value);
+}
+
+static inline uint64_t JSDRound( uint64_t accumulator, uint64_t input )
+{
+    accumulator += input * JSDPrime2;
+    accumulator  = JSDRotate(accumulator, 31);
+    return accumulator * JSDPrime1;
+}
+
+static inline uint64_t JSDMergeRound( uint64_t accumulator, uint64_t value )
+{
+    accumulator ^= JSDRound(0, value);
+    return accumulator * JSDPrime1 + JSDPrime4;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyHashBytes
+ *   XXH64: four independent lanes over 32-byte stripes, then
+ *   the remaining words, halfwords, and bytes, then avalanche.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+uint64_t JSDTidyHashBytes( const void *bytes, size_t length, uint64_t seed )
+{
+    const uint8_t *p = bytes;
+    const uint8_t *end = p + length;
+    uint64_t hash;
+
+    if (length >= 32)
+    {
+        const uint8_t *limit = end - 32;
+
+        uint64_t v1 = seed + JSDPrime1 + JSDPrime2;
+        uint64_t v2 = seed + JSDPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - JSDPrime1;
+
+        do
+        {
+            v1 = JSDRound(v1, JSDRead64(p));      p += 8;
+            v2 = JSDRound(v2, JSDRead64(p));      p += 8;
+            v3 = JSDRound(v3, JSDRead64(p));      p += 8;
+            v4 = JSDRound(v4, JSDRead64(p));      p += 8;
+        } while (p <= limit);
+
+        hash = JSDRotate(v1, 1) + JSDRotate(v2, 7) + JSDRotate(v3, 12) + JSDRotate(v4, 18);
+        hash = JSDMergeRound(hash, v1);
+        hash = JSDMergeRound(hash, v2);
+        hash = JSDMergeRound(hash, v3);
+        hash = JSDMergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + JSDPrime5;
+    }
+
+    hash += (uint64_t)length;
+
+    while (p + 8 <= end)
+    {
+        hash ^= JSDRound(0, JSDRead64(p));
+        hash  = JSDRotate(hash, 27) * JSDPrime1 + JSDPrime4;
+        p += 8;
+    }
+
+    if (p + 4 <= end)
+    {
+        hash ^= (uint64_t)JSDRead32(p) * JSDPrime1;
+        hash  = JSDRotate(hash, 23) * JSDPrime2 + JSDPrime3;
+        p += 4;
+    }
+
+    while (p < end)
+    {
+        hash ^= (*p) * JSDPrime5;
+        hash  = JSDRotate(hash, 11) * JSDPrime1;
+        p++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= JSDPrime2;
+    hash ^= hash >> 29;
+    hash *= JSDPrime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyLibraryHash
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+uint64_t JSDTidyLibraryHash( void )
+{
+    static uint64_t libraryHash;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        ctmbstr version = tidyLibraryVersion();
+        ctmbstr date = tidyReleaseDate();
+
+        libraryHash = JSDTidyHashBytes(version, strlen(version), 0);
+        libraryHash = JSDTidyHashBytes(date, strlen(date), libraryHash);
+    });
+
+    return libraryHash;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyResultKeyMake
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+JSDTidyResultKey JSDTidyResultKeyMake( const void *bytes, size_t length, uint64_t fingerprint )
+{
+    JSDTidyResultKey key;
+
+    key.sourceHash         = JSDTidyHashBytes(bytes, length, 0);
+    key.sourceLength       = length;
+    key.optionsFingerprint = fingerprint;
+    key.libraryHash        = JSDTidyLibraryHash();
+
+    return key;
+}
+
+
+#pragma mark - Implementation
+
+
+@implementation JSDTidyCachedResult
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @cost
+ *   Counts the text as UTF-16, which is what it becomes once it's
+ *   read, plus a little for the instances themselves.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)cost
+{
+    return 256 + self.tidyData.length + self.errorText.length * sizeof(unichar) + self.errorArray.byteCount;
+}
+
+
+@end
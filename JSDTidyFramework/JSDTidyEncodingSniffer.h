@@ -0,0 +1,55 @@
+//
+//  JSDTidyEncodingSniffer.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+
+/** How sure the sniffer is about a suggested encoding, in rank order. */
+typedef NS_ENUM(NSUInteger, JSDTidyEncodingConfidence) {
+    JSDTidyEncodingConfidenceNone      = 0,
+    JSDTidyEncodingConfidenceFallback  = 1,   // A reasonable default for legacy text.
+    JSDTidyEncodingConfidenceValidated = 2,   // The bytes decode cleanly.
+    JSDTidyEncodingConfidenceDeclared  = 3,   // Named by <meta charset>.
+    JSDTidyEncodingConfidenceCertain   = 4,   // Byte order mark.
+};
+
+
+/** A single suggestion made by @c JSDTidySniffEncodings(). */
+typedef struct JSDTidyEncodingCandidate {
+    NSStringEncoding encoding;
+    JSDTidyEncodingConfidence confidence;
+} JSDTidyEncodingCandidate;
+
+
+/** The most candidates that @c JSDTidySniffEncodings() will suggest. */
+#define JSDTidyEncodingMaxCandidates 4
+
+
+/**
+ *  Suggests encodings for @c bytes without decoding them.
+ *
+ *  The suggestions come from, in order: a byte order mark (which ends the
+ *  search immediately); an HTML5-style @c <meta @c charset> prescan of the
+ *  first 1024 bytes; a UTF-8 validation pass, which stops at the first
+ *  invalid sequence; and finally the legacy defaults that browsers use.
+ *
+ *  @param bytes The data to examine.
+ *  @param length The number of bytes in @c bytes.
+ *  @param candidates An array that receives up to
+ *    @c JSDTidyEncodingMaxCandidates suggestions, most confident first,
+ *    without duplicates.
+ *
+ *  @return Returns the number of candidates written.
+ */
+NSUInteger JSDTidySniffEncodings( const uint8_t *bytes, size_t length, JSDTidyEncodingCandidate *candidates );
+
+/**
+ *  Indicates whether @c bytes are well-formed UTF-8, rejecting overlong
+ *  forms, surrogates, and code points beyond U+10FFFF. ASCII is checked
+ *  a vector at a time.
+ */
+BOOL JSDTidyIsValidUTF8( const uint8_t *bytes, size_t length );
@@ -0,0 +1,369 @@
+//
+//  JSDTidyEncodingSniffer.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyEncodingSniffer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+#pragma mark - Definitions
+
+
+/* The HTML5 prescan only looks this far into the document. */
+#define JSDSnifferPrescanLength ((size_t)1024)
+
+
+#pragma mark - UTF-8 Validation
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDSnifferASCIIRun
+ *   Returns the length of the run of ASCII at the start of `bytes`,
+ *   to within one block.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline size_t JSDSnifferASCIIRun( const uint8_t *bytes, size_t length )
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= length; i += 16)
+    {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(bytes + i))))
+        {
+            break;
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= length; i += 16)
+    {
+        if (vmaxvq_u8(vld1q_u8(bytes + i)) >= 0x80)
+        {
+            break;
+        }
+    }
+#else
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+
+        if (word & 0x8080808080808080ULL)
+        {
+            break;
+        }
+    }
+#endif
+
+    while (i < length && bytes[i] < 0x80)
+    {
+        i++;
+    }
+
+    return i;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyIsValidUTF8
+ *   ASCII is skipped in blocks; multibyte sequences are checked
+ *   against the well-formed byte sequences of Unicode table 3-7.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+BOOL JSDTidyIsValidUTF8( const uint8_t *bytes, size_t length )
+{
+    size_t i = 0;
+
+    while (i < length)
+    {
+        i += JSDSnifferASCIIRun(bytes + i, length - i);
+
+        if (i >= length)
+        {
+            break;
+        }
+
+        uint8_t lead = bytes[i];
+        size_t count;
+        uint8_t low = 0x80;
+        uint8_t high = 0xBF;
+
+        if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            count = 1;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            count = 2;
+            low = lead == 0xE0 ? 0xA0 : 0x80;
+            high = lead == 0xED ? 0x9F : 0xBF;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            count = 3;
+            low = lead == 0xF0 ? 0x90 : 0x80;
+            high = lead == 0xF4 ? 0x8F : 0xBF;
+        }
+        else
+        {
+            return NO;
+        }
+
+        if (length - i <= count)
+        {
+            return NO;
+        }
+
+        if (bytes[i + 1] < low || bytes[i + 1] > high)
+        {
+            return NO;
+        }
+
+        for (size_t j = 2; j <= count; j++)
+        {
+            if ((bytes[i + j] & 0xC0) != 0x80)
+            {
+                return NO;
+            }
+        }
+
+        i += count + 1;
+    }
+
+    return YES;
+}
+
+
+#pragma mark - Meta Prescan
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDSnifferFind
+ *   Case-insensitive search for an ASCII, lowercase `needle`.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static size_t JSDSnifferFind( const uint8_t *bytes, size_t start, size_t end, const char *needle )
+{
+    size_t needleLength = strlen(needle);
+
+    for (size_t i = start; i + needleLength <= end; i++)
+    {
+        size_t j = 0;
+
+        while (j < needleLength && (bytes[i + j] | 0x20) == (uint8_t)needle[j])
+        {
+            j++;
+        }
+
+        if (j == needleLength)
+        {
+            return i;
+        }
+    }
+
+    return end;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDSnifferEncodingForName
+ *   Converts an IANA charset name to an NSStringEncoding, treating
+ *   UTF-16 declarations as UTF-8 as HTML5 requires (a real UTF-16
+ *   document would have had a byte order mark).
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSStringEncoding JSDSnifferEncodingForName( const uint8_t *name, size_t length )
+{
+    CFStringRef ianaName = CFStringCreateWithBytes(kCFAllocatorDefault, name, (CFIndex)length, kCFStringEncodingASCII, false);
+
+    if (!ianaName)
+    {
+        return 0;
+    }
+
+    CFStringEncoding cfEncoding = CFStringConvertIANACharSetNameToEncoding(ianaName);
+
+    CFRelease(ianaName);
+
+    if (cfEncoding == kCFStringEncodingInvalidId)
+    {
+        return 0;
+    }
+
+    NSStringEncoding encoding = CFStringConvertEncodingToNSStringEncoding(cfEncoding);
+
+    if (encoding == NSUnicodeStringEncoding || encoding == NSUTF16BigEndianStringEncoding || encoding == NSUTF16LittleEndianStringEncoding)
+    {
+        encoding = NSUTF8StringEncoding;
+    }
+
+    return encoding;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDSnifferPrescan
+ *   A simplified HTML5 prescan: finds `charset` within a <meta>
+ *   tag, which covers both <meta charset="x"> and the http-equiv
+ *   form's content="text/html; charset=x".
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSStringEncoding JSDSnifferPrescan( const uint8_t *bytes, size_t length )
+{
+    size_t end = MIN(length, JSDSnifferPrescanLength);
+    size_t position = 0;
+
+    while ((position = JSDSnifferFind(bytes, position, end, "<meta")) < end)
+    {
+        size_t tagEnd = position;
+
+        while (tagEnd < end && bytes[tagEnd] != '>')
+        {
+            tagEnd++;
+        }
+
+        size_t charset = JSDSnifferFind(bytes, position + 5, tagEnd, "charset");
+
+        if (charset < tagEnd)
+        {
+            size_t i = charset + 7;
+
+            while (i < tagEnd && (bytes[i] == ' ' || bytes[i] == '\t' || bytes[i] == '\n' || bytes[i] == '\r'))
+            {
+                i++;
+            }
+
+            if (i < tagEnd && bytes[i] == '=')
+            {
+                i++;
+
+                while (i < tagEnd && (bytes[i] == ' ' || bytes[i] == '"' || bytes[i] == '\''))
+                {
+                    i++;
+                }
+
+                size_t nameStart = i;
+
+                while (i < tagEnd && bytes[i] != '"' && bytes[i] != '\'' && bytes[i] != ';' && bytes[i] != ' ' && bytes[i] != '/')
+                {
+                    i++;
+                }
+
+                if (i > nameStart)
+                {
+                    return JSDSnifferEncodingForName(bytes + nameStart, i - nameStart);
+                }
+            }
+        }
+
+        position = tagEnd;
+    }
+
+    return 0;
+}
+
+
+#pragma mark - Public Functions
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDSnifferAdd
+ *   Adds a candidate unless it's already present.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void JSDSnifferAdd( JSDTidyEncodingCandidate *candidates, NSUInteger *count, NSStringEncoding encoding, JSDTidyEncodingConfidence confidence )
+{
+    if (encoding == 0 || *count >= JSDTidyEncodingMaxCandidates)
+    {
+        return;
+    }
+
+    for (NSUInteger i = 0; i < *count; i++)
+    {
+        if (candidates[i].encoding == encoding)
+        {
+            return;
+        }
+    }
+
+    candidates[*count].encoding = encoding;
+    candidates[*count].confidence = confidence;
+    (*count)++;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidySniffEncodings
+ *   Candidates are added in order of decreasing confidence, so the
+ *   array needs no sorting.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+NSUInteger JSDTidySniffEncodings( const uint8_t *bytes, size_t length, JSDTidyEncodingCandidate *candidates )
+{
+    NSUInteger count = 0;
+
+    /* Byte order marks. The UTF-32 marks have to be checked before
+     * the UTF-16 marks that they start with.
+     */
+
+    if (length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+    {
+        JSDSnifferAdd(candidates, &count, NSUTF8StringEncoding, JSDTidyEncodingConfidenceCertain);
+        return count;
+    }
+
+    if (length >= 4 && bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[2] == 0x00 && bytes[3] == 0x00)
+    {
+        JSDSnifferAdd(candidates, &count, NSUTF32LittleEndianStringEncoding, JSDTidyEncodingConfidenceCertain);
+        return count;
+    }
+
+    if (length >= 4 && bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0xFE && bytes[3] == 0xFF)
+    {
+        JSDSnifferAdd(candidates, &count, NSUTF32BigEndianStringEncoding, JSDTidyEncodingConfidenceCertain);
+        return count;
+    }
+
+    if (length >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+    {
+        JSDSnifferAdd(candidates, &count, NSUTF16LittleEndianStringEncoding, JSDTidyEncodingConfidenceCertain);
+        return count;
+    }
+
+    if (length >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+    {
+        JSDSnifferAdd(candidates, &count, NSUTF16BigEndianStringEncoding, JSDTidyEncodingConfidenceCertain);
+        return count;
+    }
+
+
+    /* A declared charset is trusted over validation, except that a
+     * declaration of UTF-8 is only as good as the bytes themselves.
+     */
+
+    NSStringEncoding declared = JSDSnifferPrescan(bytes, length);
+    BOOL isUTF8 = JSDTidyIsValidUTF8(bytes, length);
+
+    if (declared && (declared != NSUTF8StringEncoding || isUTF8))
+    {
+        JSDSnifferAdd(candidates, &count, declared, JSDTidyEncodingConfidenceDeclared);
+    }
+
+    if (isUTF8)
+    {
+        JSDSnifferAdd(candidates, &count, NSUTF8StringEncoding, JSDTidyEncodingConfidenceValidated);
+    }
+
+
+    /* The legacy defaults. Windows-1252 is what browsers assume for
+     * undeclared legacy text; Mac Roman and Latin-1 can decode any
+     * bytes at all.
+     */
+
+    JSDSnifferAdd(candidates, &count, NSWindowsCP1252StringEncoding, JSDTidyEncodingConfidenceFallback);
+    JSDSnifferAdd(candidates, &count, NSMacOSRomanStringEncoding, JSDTidyEncodingConfidenceFallback);
+    JSDSnifferAdd(candidates, &count, NSISOLatin1StringEncoding, JSDTidyEncodingConfidenceFallback);
+
+    return count;
+}
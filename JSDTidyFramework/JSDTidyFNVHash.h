@@ -0,0 +1,38 @@
+//
+//  JSDTidyFNVHash.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+
+/**
+ *  The 64-bit FNV-1a hash, for the small keys that the framework hashes
+ *  one field at a time: message identities and option fingerprints. It's
+ *  the same on every platform and from one launch to the next. Large
+ *  buffers use @c JSDTidyHashBytes instead.
+ */
+
+
+/**
+ *  The starting value for @c JSDTidyFNVHash.
+ */
+#define JSDTidyFNVHashSeed 0xcbf29ce484222325ULL
+
+
+/**
+ *  Continues @c hash over @c length bytes.
+ */
+static inline uint64_t JSDTidyFNVHash( uint64_t hash, const void *bytes, size_t length )
+{
+    const uint8_t *byte = bytes;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ byte[i]) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
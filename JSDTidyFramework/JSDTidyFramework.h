@@ -16,4 +16,8 @@ FOUNDATION_EXPORT const unsigned char JSDTidyFrameworkVersionString[];
 #import <JSDTidyFramework/JSDTidyModel.h>
 #import <JSDTidyFramework/JSDTidyModelDelegate.h>
 #import <JSDTidyFramework/JSDTidyOption.h>
+#import <JSDTidyFramework/JSDTidyOptionSet.h>
+#import <JSDTidyFramework/JSDTidyResultCache.h>
+#import <JSDTidyFramework/JSDTidyBatchProcessor.h>
 #import <JSDTidyFramework/JSDTidyMessage.h>
+#import <JSDTidyFramework/JSDTidyMessageChanges.h>
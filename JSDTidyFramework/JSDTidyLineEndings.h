@@ -0,0 +1,34 @@
+//
+//  JSDTidyLineEndings.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+
+/**
+ *  Line ending normalization for UTF-8 (or any ASCII-compatible) text.
+ *
+ *  The search for carriage returns uses SSE2, AVX2, or NEON depending on
+ *  the architecture being compiled for, and falls back to @c memchr
+ *  otherwise. Because @c CR and @c LF never occur within a multibyte UTF-8
+ *  sequence, it's safe to work on the bytes directly.
+ */
+
+
+/**
+ *  Returns the offset of the first carriage return in @c bytes, or
+ *  @c length if there isn't one.
+ */
+size_t JSDLineEndingsFindCR( const uint8_t *bytes, size_t length );
+
+/**
+ *  Converts every @c CRLF and lone @c CR in @c bytes to @c LF in place, in
+ *  a single pass. When there's no carriage return this only reads the
+ *  buffer, and never writes to it.
+ *
+ *  @return Returns the new length, which is never longer than @c length.
+ */
+size_t JSDLineEndingsNormalize( uint8_t *bytes, size_t length );
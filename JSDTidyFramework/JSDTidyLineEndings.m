@@ -0,0 +1,120 @@
+//
+//  JSDTidyLineEndings.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyLineEndings.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+#pragma mark - Searching
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDLineEndingsFindCR
+ *   Compares a full vector of bytes at a time, and only drops to
+ *   byte-by-byte work for the tail.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+size_t JSDLineEndingsFindCR( const uint8_t *bytes, size_t length )
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256i cr32 = _mm256_set1_epi8('\r');
+
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(bytes + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, cr32));
+
+        if (mask)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i cr16 = _mm_set1_epi8('\r');
+
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(bytes + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, cr16));
+
+        if (mask)
+        {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t cr16 = vdupq_n_u8('\r');
+
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t matches = vceqq_u8(vld1q_u8(bytes + i), cr16);
+
+        if (vmaxvq_u8(matches))
+        {
+            /* Narrow each byte to a nibble so the match position can be
+             * read from a single 64-bit value.
+             */
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+
+            return i + (size_t)(__builtin_ctzll(mask) >> 2);
+        }
+    }
+#endif
+
+    const uint8_t *found = memchr(bytes + i, '\r', length - i);
+
+    return found ? (size_t)(found - bytes) : length;
+}
+
+
+#pragma mark - Normalization
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDLineEndingsNormalize
+ *   Runs of bytes between carriage returns are moved down in one
+ *   piece; only the carriage returns themselves are handled
+ *   individually.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+size_t JSDLineEndingsNormalize( uint8_t *bytes, size_t length )
+{
+    size_t read = JSDLineEndingsFindCR(bytes, length);
+    size_t write = read;
+
+    while (read < length)
+    {
+        /* bytes[read] is a carriage return. */
+
+        bytes[write++] = '\n';
+        read++;
+
+        if (read < length && bytes[read] == '\n')
+        {
+            read++;
+        }
+
+        size_t run = JSDLineEndingsFindCR(bytes + read, length - read);
+
+        if (run && write != read)
+        {
+            memmove(bytes + write, bytes + read, run);
+        }
+
+        write += run;
+        read += run;
+    }
+
+    return write;
+}
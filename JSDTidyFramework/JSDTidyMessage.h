@@ -91,14 +91,31 @@
  */
 @property (nonatomic, strong, readonly) NSString *message;
 
+/**
+ *  The location packed into a single integer, @c line in the upper
+ *  32 bits and @c column in the lower 32 bits, so that comparing keys
+ *  orders messages by line and then by column.
+ */
+@property (nonatomic, assign, readonly) uint64_t locationKey;
+
+/**
+ *  Identifies the message text without formatting it: the message code's
+ *  ordinal in the upper 24 bits, and a hash of the message's arguments in
+ *  the lower 40 bits. Messages with the same @c messageKey have the same
+ *  @c message.
+ */
+@property (nonatomic, assign, readonly) uint64_t messageKey;
+
 /**
  *  This property can be used to specify a sort order against
  *  the line number, column number, and localized description
- *  of a particular message.
+ *  of a particular message. It's the message itself, which sorts
+ *  with @c compare: using the packed keys, so it's suitable as the
+ *  key for an @c NSSortDescriptor.
  *
  *  It's suggested to use the custom comparitor instead.
  */
-@property (nonatomic, strong, readonly) NSString *sortKey;
+@property (nonatomic, strong, readonly) JSDTidyMessage *sortKey;
 
 
 #pragma mark - Instance Methods
@@ -107,7 +124,8 @@
 /**
  *  Compares the receiver with JSDTidyMessage to determine if they
  *  are equal. They are considered equal if the line, column, and
- *  message contain the same values.
+ *  message contain the same values, which is determined from
+ *  @c locationKey and @c messageKey.
  *  @param JSDTidyMessage An instance of JSDTidyMessage to compare
  *  for equality.
  */
@@ -123,4 +141,13 @@
 -(NSComparisonResult)tidyMessageLocationCompare:(JSDTidyMessage *)JSDTidyMessage;
 
 
+/**
+ *  The same as @c tidyMessageLocationCompare:, so that @c sortKey can be
+ *  used with the default @c NSSortDescriptor selector.
+ *  @param JSDTidyMessage An instance of JSDTidyMessage to be
+ *  compared against.
+ */
+-(NSComparisonResult)compare:(JSDTidyMessage *)JSDTidyMessage;
+
+
 @end
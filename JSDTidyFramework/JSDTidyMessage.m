@@ -6,7 +6,10 @@
 //
 
 #import "JSDTidyMessage.h"
+#import "JSDTidyMessageList.h"
+#import "JSDTidyMessageFormat.h"
 #import "JSDTidyCommonHeaders.h"
+#import "JSDTidyPlatform.h"
 
 
 #pragma mark - Category
@@ -23,6 +26,28 @@
 #pragma mark - Implementation
 
 @implementation JSDTidyMessage
+{
+    JSDTidyMessageFormat *_format;   // For formatting `message` on demand.
+    NSData *_arguments;              // The list's captured arguments.
+    uint32_t _argumentsOffset;
+    uint32_t _argumentsLength;
+    JSDTidyLock _lock;               // Protects the above and `message`.
+}
+
+@synthesize message = _message;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDMessageKeyMake
+ *   The ordinal takes the upper 24 bits; there are only a few
+ *   hundred message codes.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline uint64_t JSDMessageKeyMake( uint32_t ordinal, const void *arguments, size_t length )
+{
+    uint64_t hash = JSDTidyFNVHash(JSDTidyFNVHashSeed, arguments, length);
+
+    return ((uint64_t)ordinal << 40) | (hash & 0xFFFFFFFFFFULL);
+}
 
 
 #pragma mark - Initialization
@@ -39,21 +64,22 @@
 {
     if (self = [super init])
     {
-        NSString *formatString;
-        /* Get our localized format string from the message code. */
-        if ( strcmp(message, "UNDEFINED") == 0 )
-            formatString = @"%s";
-        else
-            formatString = JSDLocalizedString(@(message), nil);
-        
-        /* And fill in the arguments from the va_list. */
-        _message = [[NSString alloc] initWithFormat:formatString arguments:arguments];
+        /* Format the message from the precompiled catalog. */
+        JSDTidyMessageFormat *format = [JSDTidyMessageFormat formatForCode:message];
+        NSMutableData *capturedArguments = [[NSMutableData alloc] init];
+
+        [format captureArguments:arguments intoData:capturedArguments];
+
+        _message = [format messageWithArguments:capturedArguments.bytes length:capturedArguments.length];
 
         /* Set the rest of the remaining backing iVars */
         
+        _lock = JSDTidyLockInit;
         _level = level;
         _line = line;
         _column = column;
+        _locationKey = ((uint64_t)line << 32) | column;
+        _messageKey = JSDMessageKeyMake(format.ordinal, capturedArguments.bytes, capturedArguments.length);
         
     }
     
@@ -61,6 +87,32 @@
 }
 
 
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithRecord:arguments:
+ *   Used by JSDTidyMessageList; the message isn't formatted until
+ *   it's needed.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithRecord:(const JSDTidyReportRecord *)record
+                     arguments:(NSData *)arguments
+{
+    if (self = [super init])
+    {
+        _lock            = JSDTidyLockInit;
+        _level           = record->level;
+        _line            = record->line;
+        _column          = record->column;
+        _format          = [JSDTidyMessageFormat formatWithOrdinal:record->ordinal];
+        _arguments       = arguments;
+        _argumentsOffset = record->argumentsOffset;
+        _argumentsLength = record->argumentsLength;
+        _locationKey     = ((uint64_t)record->line << 32) | record->column;
+        _messageKey      = JSDMessageKeyMake(record->ordinal, (const uint8_t *)arguments.bytes + _argumentsOffset, _argumentsLength);
+    }
+
+    return self;
+}
+
+
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * - init
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
@@ -199,12 +251,38 @@
 }
 
 
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @message
+ *   Formatted from the captured arguments the first time it's read.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)message
+{
+    JSDTidyLockLock(&_lock);
+
+    if (!_message && _format)
+    {
+        _message = [_format messageWithArguments:(const uint8_t *)_arguments.bytes + _argumentsOffset length:_argumentsLength];
+
+        _format = nil;
+        _arguments = nil;
+    }
+
+    NSString *message = _message;
+
+    JSDTidyLockUnlock(&_lock);
+
+    return message;
+}
+
+
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * @sortKey
+ *   Sort descriptors using this key call `compare:`, which uses the
+ *   packed keys rather than building a string for every message.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (NSString *)sortKey
+- (JSDTidyMessage *)sortKey
 {
-    return [NSString stringWithFormat:@"%08u%08u%@", self.line, self.column, self.message];
+    return self;
 }
 
 
@@ -233,10 +311,7 @@
         return NO;
     }
     
-    BOOL equalLocationString = [self.locationString isEqualToString:JSDTidyMessage.locationString];
-    BOOL equalMessage = [self.message isEqualToString:JSDTidyMessage.message];
-    
-    return equalLocationString && equalMessage;
+    return (self.locationKey == JSDTidyMessage.locationKey) && (self.messageKey == JSDTidyMessage.messageKey);
 }
 
 
@@ -264,7 +339,7 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (NSUInteger)hash
 {
-  return [self.locationString hash] ^ [self.message hash];
+    return (NSUInteger)((self.locationKey * 0x9E3779B97F4A7C15ULL) ^ self.messageKey);
 }
 
 
@@ -273,21 +348,31 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 -(NSComparisonResult)tidyMessageLocationCompare:(JSDTidyMessage *)message
 {
-    NSComparisonResult result;
-    
-    result = [@(self.line) compare:@(message.line)];
-    
-    if (result == NSOrderedSame)
+    uint64_t selfKey = self.locationKey;
+    uint64_t otherKey = message.locationKey;
+
+    if (selfKey != otherKey)
     {
-        result = [@(self.column) compare:@(message.column)];
-        
-        if (result == NSOrderedSame)
-        {
-            result = [self.message localizedStandardCompare:message.message];
-        }
+        return selfKey < otherKey ? NSOrderedAscending : NSOrderedDescending;
     }
-    
-    return result;
+
+    /* Only messages at the same location need their text. */
+
+    if (self.messageKey == message.messageKey)
+    {
+        return NSOrderedSame;
+    }
+
+    return [self.message localizedStandardCompare:message.message];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - compare:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+-(NSComparisonResult)compare:(JSDTidyMessage *)message
+{
+    return [self tidyMessageLocationCompare:message];
 }
 
 
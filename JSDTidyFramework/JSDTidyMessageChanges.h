@@ -0,0 +1,56 @@
+//
+//  JSDTidyMessageChanges.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+
+/**
+ *  @c JSDTidyMessageChanges describes how @c [JSDTidyModel @c errorArray]
+ *  changed from one tidying operation to the next, so that clients can
+ *  update their own structures incrementally rather than rebuilding them.
+ *
+ *  Messages are matched by identity (level, location, message code, and
+ *  arguments), so a message that merely moved within the array is
+ *  unchanged, while a message whose line number changed has been removed
+ *  and another inserted.
+ */
+@interface JSDTidyMessageChanges : NSObject
+
+
+/**
+ *  The array of messages that these changes were computed against. This
+ *  is a weak reference; clients can compare it against the array that
+ *  they last used to confirm that the changes apply to them.
+ */
+@property (nonatomic, weak, readonly) NSArray *previousMessages;
+
+/**
+ *  Indexes within the new @c errorArray of messages that are new.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet *insertedIndexes;
+
+/**
+ *  Indexes within @c previousMessages of messages that are gone.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet *removedIndexes;
+
+/**
+ *  Indexes within the new @c errorArray of messages that were also in
+ *  @c previousMessages. See @c previousIndexForIndex:.
+ */
+@property (nonatomic, strong, readonly) NSIndexSet *unchangedIndexes;
+
+/**
+ *  For a message in the new @c errorArray, returns the index of the same
+ *  message within @c previousMessages, or @c NSNotFound if it's new.
+ *
+ *  @param index An index within the new @c errorArray.
+ */
+- (NSUInteger)previousIndexForIndex:(NSUInteger)index;
+
+
+@end
@@ -0,0 +1,88 @@
+//
+//  JSDTidyMessageChanges.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyMessageChanges.h"
+#import "JSDTidyMessageList.h"
+
+
+#pragma mark - Implementation
+
+
+@implementation JSDTidyMessageChanges
+{
+    NSUInteger *_previousIndexes;  // By new index; NSNotFound for insertions.
+    NSUInteger _count;
+}
+
+
+#pragma mark - Initialization and Deallocation
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithPreviousMessages:previousIndexes:count:
+ *   Takes ownership of `previousIndexes`, which must have been
+ *   allocated with malloc. If it's NULL, because it couldn't be
+ *   allocated, every message is reported as changed.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithPreviousMessages:(NSArray *)previousMessages
+                         previousIndexes:(NSUInteger *)previousIndexes
+                                   count:(NSUInteger)count
+{
+    if (self = [super init])
+    {
+        _previousMessages = previousMessages;
+        _previousIndexes = previousIndexes;
+        _count = count;
+
+        NSMutableIndexSet *inserted = [[NSMutableIndexSet alloc] init];
+        NSMutableIndexSet *unchanged = [[NSMutableIndexSet alloc] init];
+        NSMutableIndexSet *removed = [[NSMutableIndexSet alloc] initWithIndexesInRange:NSMakeRange(0, previousMessages.count)];
+
+        for (NSUInteger i = 0; i < count; i++)
+        {
+            if (!previousIndexes || previousIndexes[i] == NSNotFound)
+            {
+                [inserted addIndex:i];
+            }
+            else
+            {
+                [unchanged addIndex:i];
+                [removed removeIndex:previousIndexes[i]];
+            }
+        }
+
+        _insertedIndexes = inserted;
+        _unchangedIndexes = unchanged;
+        _removedIndexes = removed;
+    }
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - dealloc
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)dealloc
+{
+    free(_previousIndexes);
+}
+
+
+#pragma mark - Instance Methods
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - previousIndexForIndex:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)previousIndexForIndex:(NSUInteger)index
+{
+    return (_previousIndexes && index < _count) ? _previousIndexes[index] : NSNotFound;
+}
+
+
+@end
@@ -0,0 +1,82 @@
+//
+//  JSDTidyMessageFormat.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+@import HTMLTidy;
+
+
+/**
+ *  @c JSDTidyMessageFormat describes the localized format for a single
+ *  @b libtidy message code, and knows how to capture that message's
+ *  arguments from a @c va_list into a compact byte representation, and
+ *  later to build the localized message from those bytes.
+ *
+ *  This lets @c JSDTidyModel record messages during a run without doing
+ *  any formatting; the text is only built when a message is read.
+ *
+ *  Formats are created once per message code and are shared; they are
+ *  immutable and safe to use from any thread.
+ */
+@interface JSDTidyMessageFormat : NSObject
+
+
+/**
+ *  Returns the shared format for a @b libtidy message code, creating it
+ *  if needed.
+ *
+ *  @param code The message code given to the report callback.
+ */
++ (JSDTidyMessageFormat *)formatForCode:(ctmbstr)code;
+
+/**
+ *  Returns the shared format for a message code that didn't come from
+ *  @b libtidy, e.g., one read from an archive, creating it if needed.
+ *
+ *  @param code The message code.
+ */
++ (JSDTidyMessageFormat *)formatForCodeString:(NSString *)code;
+
+/**
+ *  Returns the shared format with the given @c ordinal.
+ */
++ (JSDTidyMessageFormat *)formatWithOrdinal:(uint32_t)ordinal;
+
+/**
+ *  A small integer that uniquely identifies this format's message code
+ *  for the life of the process.
+ */
+@property (nonatomic, assign, readonly) uint32_t ordinal;
+
+/**
+ *  The @b libtidy message code, e.g., @b MISSING_ENDTAG_FOR.
+ */
+@property (nonatomic, strong, readonly) NSString *code;
+
+/**
+ *  The localized format string.
+ */
+@property (nonatomic, strong, readonly) NSString *formatString;
+
+/**
+ *  Appends the arguments for this message from @c arguments to @c data.
+ *  Every argument is consumed from the @c va_list, so it must not be used
+ *  again afterwards.
+ */
+- (void)captureArguments:(va_list)arguments intoData:(NSMutableData *)data;
+
+/**
+ *  Builds the localized message from arguments previously captured by
+ *  @c captureArguments:intoData:.
+ *
+ *  @param bytes The first byte of the captured arguments.
+ *  @param length The number of bytes captured.
+ */
+- (NSString *)messageWithArguments:(const uint8_t *)bytes length:(NSUInteger)length;
+
+
+@end
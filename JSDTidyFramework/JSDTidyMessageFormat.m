@@ -0,0 +1,727 @@
+//
+//  JSDTidyMessageFormat.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyMessageFormat.h"
+#import "JSDTidyPlatform.h"
+
+
+#pragma mark - Definitions
+
+
+/* The most arguments that any libtidy message takes is three; this
+ * leaves plenty of room.
+ */
+#define JSDFormatMaxArguments 9
+
+typedef enum JSDFormatArgumentType {
+    JSDFormatArgumentNone = 0,
+    JSDFormatArgumentInt,          // int, unsigned, and char, all promoted to int.
+    JSDFormatArgumentLong,         // long, long long, size_t, pointers.
+    JSDFormatArgumentString,       // A C string, captured as UTF-8.
+} JSDFormatArgumentType;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDFormatConversion
+ *   A single printf-style conversion within a format string.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDFormatConversion {
+    size_t start;                  // Offset of the `%`.
+    size_t end;                    // Offset following the conversion character.
+    int slot;                      // Zero-based argument index.
+    JSDFormatArgumentType type;
+    char spec[16];                 // The conversion without any `n$`, for snprintf.
+} JSDFormatConversion;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDFormatSegment
+ *   A precompiled piece of a format: either literal text (with any
+ *   `%%` already collapsed) or a conversion to fill in.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDFormatSegment {
+    JSDFormatArgumentType type;    // JSDFormatArgumentNone for literal text.
+    BOOL isPlain;                  // %s, %d, or %u without flags, width, or precision.
+    int slot;
+    uint32_t offset;               // Literal text within the format's literal buffer.
+    uint32_t length;
+    char spec[16];
+} JSDFormatSegment;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDFormatNextConversion
+ *   Finds the next conversion at or after `*index`. Returns 1 if one
+ *   was found, 0 at the end of the format, or -1 if the conversion
+ *   is one that we can't capture (e.g., %@, %f, or `*` widths).
+ *   `%%` is not a conversion and is left for the caller to copy.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static int JSDFormatNextConversion( const char *format, size_t *index, int *nextSlot, JSDFormatConversion *conversion )
+{
+    size_t i = *index;
+
+    while (format[i])
+    {
+        if (format[i] != '%')
+        {
+            i++;
+            continue;
+        }
+
+        if (format[i + 1] == '%')
+        {
+            i += 2;
+            continue;
+        }
+
+        size_t start = i++;
+        int slot = *nextSlot;
+
+        /* Positional argument, e.g., %2$s. */
+
+        size_t digits = i;
+        int position = 0;
+
+        while (format[digits] >= '0' && format[digits] <= '9')
+        {
+            position = position * 10 + (format[digits++] - '0');
+        }
+
+        if (format[digits] == '$' && position > 0)
+        {
+            slot = position - 1;
+            i = digits + 1;
+        }
+
+        size_t specStart = i;
+
+        while (format[i] && strchr("-+ #0'", format[i]))
+        {
+            i++;
+        }
+
+        while (format[i] >= '0' && format[i] <= '9')
+        {
+            i++;
+        }
+
+        if (format[i] == '.')
+        {
+            i++;
+
+            while (format[i] >= '0' && format[i] <= '9')
+            {
+                i++;
+            }
+        }
+
+        BOOL isLong = NO;
+
+        while (format[i] && strchr("hlqzjt", format[i]))
+        {
+            isLong = isLong || (format[i] != 'h');
+            i++;
+        }
+
+        char kind = format[i];
+        JSDFormatArgumentType type;
+
+        if (kind == 'c' && isLong)
+        {
+            return -1;
+        }
+        else if (kind && strchr("diuxXoc", kind))
+        {
+            type = isLong ? JSDFormatArgumentLong : JSDFormatArgumentInt;
+        }
+        else if (kind == 's' && !isLong)
+        {
+            type = JSDFormatArgumentString;
+        }
+        else if (kind == 'p')
+        {
+            type = JSDFormatArgumentLong;
+        }
+        else
+        {
+            return -1;
+        }
+
+        i++;
+
+        size_t specLength = i - specStart;
+
+        if (slot >= JSDFormatMaxArguments || specLength + 2 > sizeof(conversion->spec))
+        {
+            return -1;
+        }
+
+        conversion->start = start;
+        conversion->end = i;
+        conversion->slot = slot;
+        conversion->type = type;
+        conversion->spec[0] = '%';
+        memcpy(conversion->spec + 1, format + specStart, specLength);
+        conversion->spec[specLength + 1] = '\0';
+
+        *index = i;
+        *nextSlot = slot + 1;
+
+        return 1;
+    }
+
+    *index = i;
+
+    return 0;
+}
+
+
+#pragma mark - Category
+
+
+@interface JSDTidyMessageFormat ()
+
+@property (nonatomic, assign, readwrite) uint32_t ordinal;
+
+@property (nonatomic, strong, readwrite) NSString *code;
+
+@property (nonatomic, strong, readwrite) NSString *formatString;
+
+@end
+
+
+#pragma mark - Implementation
+
+
+@implementation JSDTidyMessageFormat
+{
+    char *_codeUTF8;                                          // For verifying cache hits.
+    char *_literals;                                          // All of the literal text, back to back.
+    JSDFormatSegment *_segments;                              // The precompiled format.
+    int _segmentCount;
+    uint32_t _literalLength;                                  // Total bytes of literal text.
+    JSDFormatArgumentType _types[JSDFormatMaxArguments];      // Argument types, by slot.
+    int _argumentCount;
+    BOOL _isPreformatted;                                     // Unsupported conversions; format at capture.
+}
+
+
+#pragma mark - Shared Formats
+
+
+static JSDTidyLock formatsLock = JSDTidyLockInit;
+
+static NSMutableArray<JSDTidyMessageFormat *> *formatsByOrdinal;
+
+static NSMapTable *formatsByPointer;                          // libtidy's codes are static strings.
+
+static NSMutableDictionary<NSString *, JSDTidyMessageFormat *> *formatsByCode;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDFormatIsMessageCode
+ *   libtidy's message codes are the only all-caps keys in our
+ *   strings table, e.g., MISSING_ENDTAG_FOR.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static BOOL JSDFormatIsMessageCode( NSString *key )
+{
+    static NSCharacterSet *notCodeCharacters;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        notCodeCharacters = [[NSCharacterSet characterSetWithCharactersInString:@"ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"] invertedSet];
+    });
+
+    return key.length > 1 && [key rangeOfCharacterFromSet:notCodeCharacters].location == NSNotFound;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + loadCatalog (private)
+ *   Reads the strings table once and precompiles the format for
+ *   every message code in it. Must be called with the lock held.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (void)loadCatalog
+{
+    formatsByOrdinal = [[NSMutableArray alloc] init];
+    formatsByPointer = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality
+                                             valueOptions:NSPointerFunctionsStrongMemory];
+    formatsByCode    = [[NSMutableDictionary alloc] init];
+
+    NSString *path = [[NSBundle bundleForClass:self] pathForResource:@"Localizable" ofType:@"strings"];
+    NSDictionary *table = path ? [NSDictionary dictionaryWithContentsOfFile:path] : nil;
+
+    [self addFormatString:@"%s" forCode:@"UNDEFINED"];
+
+    for (NSString *key in table)
+    {
+        if (JSDFormatIsMessageCode(key) && [table[key] isKindOfClass:[NSString class]])
+        {
+            [self addFormatString:table[key] forCode:key];
+        }
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + addFormatString:forCode: (private)
+ *   Must be called with the lock held.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (JSDTidyMessageFormat *)addFormatString:(NSString *)formatString forCode:(NSString *)code
+{
+    JSDTidyMessageFormat *format = [[JSDTidyMessageFormat alloc] initWithCode:code
+                                                                 formatString:formatString
+                                                                      ordinal:(uint32_t)formatsByOrdinal.count];
+
+    [formatsByOrdinal addObject:format];
+    formatsByCode[code] = format;
+
+    return format;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + formatForCode:
+ *   This is called for every message libtidy reports, so the
+ *   common case is a single pointer lookup under a cheap lock.
+ *   Codes missing from the strings table use the code itself as
+ *   the message, just as a missing localization would.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (JSDTidyMessageFormat *)formatForCode:(ctmbstr)code
+{
+    if (!code)
+    {
+        code = "UNDEFINED";
+    }
+
+    JSDTidyMessageFormat *format;
+
+    JSDTidyLockLock(&formatsLock);
+
+    if (!formatsByOrdinal)
+    {
+        [self loadCatalog];
+    }
+
+    format = (__bridge JSDTidyMessageFormat *)NSMapGet(formatsByPointer, code);
+
+    if (!format || strcmp(format->_codeUTF8, code) != 0)
+    {
+        NSString *codeString = @(code);
+
+        format = formatsByCode[codeString];
+
+        if (!format)
+        {
+            format = [self addFormatString:codeString forCode:codeString];
+        }
+
+        NSMapInsert(formatsByPointer, code, (__bridge void *)format);
+    }
+
+    JSDTidyLockUnlock(&formatsLock);
+
+    return format;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + formatForCodeString:
+ *   Unlike formatForCode:, this doesn't remember the pointer,
+ *   because these codes don't come from libtidy's static strings.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (JSDTidyMessageFormat *)formatForCodeString:(NSString *)code
+{
+    JSDTidyMessageFormat *format;
+
+    JSDTidyLockLock(&formatsLock);
+
+    if (!formatsByOrdinal)
+    {
+        [self loadCatalog];
+    }
+
+    format = formatsByCode[code];
+
+    if (!format)
+    {
+        format = [self addFormatString:code forCode:code];
+    }
+
+    JSDTidyLockUnlock(&formatsLock);
+
+    return format;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + formatWithOrdinal:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (JSDTidyMessageFormat *)formatWithOrdinal:(uint32_t)ordinal
+{
+    JSDTidyMessageFormat *format = nil;
+
+    JSDTidyLockLock(&formatsLock);
+
+    if (ordinal < formatsByOrdinal.count)
+    {
+        format = formatsByOrdinal[ordinal];
+    }
+
+    JSDTidyLockUnlock(&formatsLock);
+
+    return format;
+}
+
+
+#pragma mark - Initialization and Deallocation
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithCode:formatString:ordinal:
+ *   Precompiles the format into segments, and works out the
+ *   argument types that it expects.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithCode:(NSString *)code formatString:(NSString *)formatString ordinal:(uint32_t)ordinal
+{
+    if (self = [super init])
+    {
+        _ordinal = ordinal;
+        _code = code;
+        _formatString = formatString;
+        _codeUTF8 = strdup(code.UTF8String);
+
+        const char *format = formatString.UTF8String;
+        size_t formatLength = strlen(format);
+
+        /* There can't be more conversions than half the length, and
+         * there's one more literal than there are conversions.
+         */
+        _segments = calloc(formatLength + 1, sizeof(JSDFormatSegment));
+        _literals = malloc(formatLength + 1);
+
+        size_t index = 0;
+        size_t literalStart = 0;
+        int nextSlot = 0;
+        int found;
+        JSDFormatConversion conversion;
+
+        while ((found = JSDFormatNextConversion(format, &index, &nextSlot, &conversion)) == 1)
+        {
+            [self addLiteral:format + literalStart length:conversion.start - literalStart];
+
+            JSDFormatSegment *segment = &_segments[_segmentCount++];
+
+            segment->type = conversion.type;
+            segment->slot = conversion.slot;
+            segment->isPlain = strcmp(conversion.spec, "%s") == 0 || strcmp(conversion.spec, "%d") == 0 || strcmp(conversion.spec, "%u") == 0;
+            memcpy(segment->spec, conversion.spec, sizeof(segment->spec));
+
+            _types[conversion.slot] = conversion.type;
+            _argumentCount = MAX(_argumentCount, conversion.slot + 1);
+
+            literalStart = conversion.end;
+        }
+
+        [self addLiteral:format + literalStart length:strlen(format + literalStart)];
+
+        /* Every slot up to the last must be used, otherwise we can't
+         * know what type to take from the va_list.
+         */
+
+        _isPreformatted = (found < 0);
+
+        for (int i = 0; i < _argumentCount; i++)
+        {
+            _isPreformatted = _isPreformatted || (_types[i] == JSDFormatArgumentNone);
+        }
+    }
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - addLiteral:length: (private)
+ *   Adds a literal segment, collapsing `%%` to `%`.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)addLiteral:(const char *)literal length:(size_t)length
+{
+    if (length == 0)
+    {
+        return;
+    }
+
+    JSDFormatSegment *segment = &_segments[_segmentCount++];
+
+    segment->type = JSDFormatArgumentNone;
+    segment->offset = _literalLength;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        _literals[_literalLength++] = literal[i];
+
+        if (literal[i] == '%' && i + 1 < length && literal[i + 1] == '%')
+        {
+            i++;
+        }
+    }
+
+    segment->length = _literalLength - segment->offset;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - dealloc
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)dealloc
+{
+    free(_codeUTF8);
+    free(_literals);
+    free(_segments);
+}
+
+
+#pragma mark - Capturing and Formatting
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - captureArguments:intoData:
+ *   Numbers are stored as 64-bit values, and strings as a 32-bit
+ *   length followed by their bytes and terminator. Formats that we
+ *   can't capture are formatted right away, and the result is
+ *   stored as a single string.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)captureArguments:(va_list)arguments intoData:(NSMutableData *)data
+{
+    if (_isPreformatted)
+    {
+        NSString *message = [[NSString alloc] initWithFormat:self.formatString arguments:arguments];
+        const char *utf8 = message.UTF8String;
+
+        [self appendString:utf8 toData:data];
+
+        return;
+    }
+
+    for (int i = 0; i < _argumentCount; i++)
+    {
+        int64_t value;
+
+        switch (_types[i])
+        {
+            case JSDFormatArgumentInt:
+                value = va_arg(arguments, int);
+                [data appendBytes:&value length:sizeof(value)];
+                break;
+
+            case JSDFormatArgumentLong:
+                value = va_arg(arguments, long);
+                [data appendBytes:&value length:sizeof(value)];
+                break;
+
+            case JSDFormatArgumentString:
+                [self appendString:va_arg(arguments, const char *) toData:data];
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - appendString:toData: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)appendString:(const char *)string toData:(NSMutableData *)data
+{
+    if (!string)
+    {
+        string = "";
+    }
+
+    uint32_t length = (uint32_t)strlen(string) + 1;
+
+    [data appendBytes:&length length:sizeof(length)];
+    [data appendBytes:string length:length];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDFormatDecimal
+ *   Writes a decimal number, returning the number of bytes written
+ *   (never more than 20).
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static size_t JSDFormatDecimal( char *output, int64_t value, BOOL isSigned )
+{
+    char digits[24];
+    size_t count = 0;
+    size_t written = 0;
+    uint64_t magnitude;
+
+    if (isSigned && value < 0)
+    {
+        output[written++] = '-';
+        magnitude = (uint64_t)(-(value + 1)) + 1;
+    }
+    else
+    {
+        magnitude = isSigned ? (uint64_t)value : (uint64_t)(uint32_t)value;
+    }
+
+    do
+    {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+
+    while (count)
+    {
+        output[written++] = digits[--count];
+    }
+
+    return written;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - messageWithArguments:length:
+ *   Sizes the message, then fills it in segment by segment. Plain
+ *   conversions are copied or converted directly; anything with
+ *   flags, width, or precision goes through snprintf.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)messageWithArguments:(const uint8_t *)bytes length:(NSUInteger)length
+{
+    if (_isPreformatted)
+    {
+        return length > sizeof(uint32_t) ? @((const char *)bytes + sizeof(uint32_t)) : @"";
+    }
+
+    /* Find each argument within the captured bytes. */
+
+    const char *strings[JSDFormatMaxArguments];
+    size_t stringLengths[JSDFormatMaxArguments];
+    int64_t numbers[JSDFormatMaxArguments];
+    size_t offset = 0;
+
+    for (int i = 0; i < _argumentCount; i++)
+    {
+        if (_types[i] == JSDFormatArgumentString)
+        {
+            uint32_t stringLength;
+
+            if (offset + sizeof(stringLength) > length)
+            {
+                return self.formatString;
+            }
+
+            memcpy(&stringLength, bytes + offset, sizeof(stringLength));
+            strings[i] = (const char *)bytes + offset + sizeof(stringLength);
+            stringLengths[i] = stringLength ? stringLength - 1 : 0;
+            offset += sizeof(stringLength) + stringLength;
+        }
+        else
+        {
+            if (offset + sizeof(int64_t) > length)
+            {
+                return self.formatString;
+            }
+
+            memcpy(&numbers[i], bytes + offset, sizeof(int64_t));
+            offset += sizeof(int64_t);
+        }
+
+        if (offset > length)
+        {
+            return self.formatString;
+        }
+    }
+
+    /* Work out how much room the message needs. */
+
+    size_t capacity = _literalLength + 1;
+
+    for (int i = 0; i < _segmentCount; i++)
+    {
+        const JSDFormatSegment *segment = &_segments[i];
+
+        if (segment->type == JSDFormatArgumentString)
+        {
+            capacity += segment->isPlain ? stringLengths[segment->slot] : (size_t)MAX(snprintf(NULL, 0, segment->spec, strings[segment->slot]), 0);
+        }
+        else if (segment->type != JSDFormatArgumentNone)
+        {
+            capacity += 64;
+        }
+    }
+
+    char *message = malloc(capacity);
+    size_t used = 0;
+
+    if (!message)
+    {
+        return @"";
+    }
+
+    for (int i = 0; i < _segmentCount; i++)
+    {
+        const JSDFormatSegment *segment = &_segments[i];
+        int written = 0;
+
+        switch (segment->type)
+        {
+            case JSDFormatArgumentNone:
+                memcpy(message + used, _literals + segment->offset, segment->length);
+                used += segment->length;
+                break;
+
+            case JSDFormatArgumentString:
+                if (segment->isPlain)
+                {
+                    memcpy(message + used, strings[segment->slot], stringLengths[segment->slot]);
+                    used += stringLengths[segment->slot];
+                }
+                else
+                {
+                    written = snprintf(message + used, capacity - used, segment->spec, strings[segment->slot]);
+                    used += (size_t)MAX(written, 0);
+                }
+                break;
+
+            case JSDFormatArgumentLong:
+                written = snprintf(message + used, capacity - used, segment->spec, (long)numbers[segment->slot]);
+                used += (size_t)MIN(MAX(written, 0), 63);
+                break;
+
+            default:
+                if (segment->isPlain)
+                {
+                    used += JSDFormatDecimal(message + used, numbers[segment->slot], segment->spec[1] == 'd');
+                }
+                else
+                {
+                    written = snprintf(message + used, capacity - used, segment->spec, (int)numbers[segment->slot]);
+                    used += (size_t)MIN(MAX(written, 0), 63);
+                }
+                break;
+        }
+    }
+
+    NSString *result = [[NSString alloc] initWithBytesNoCopy:message length:used encoding:NSUTF8StringEncoding freeWhenDone:YES];
+
+    if (!result)
+    {
+        free(message);
+        result = @"";
+    }
+
+    return result;
+}
+
+
+@end
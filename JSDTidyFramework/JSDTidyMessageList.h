@@ -0,0 +1,149 @@
+//
+//  JSDTidyMessageList.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+@import HTMLTidy;
+
+#import "JSDTidyMessage.h"
+#import "JSDTidyMessageChanges.h"
+#import "JSDTidyFNVHash.h"
+
+
+/**
+ *  A single message as reported by @b libtidy, before any formatting.
+ */
+typedef struct JSDTidyReportRecord {
+    uint32_t line;
+    uint32_t column;
+    uint32_t ordinal;              // The JSDTidyMessageFormat for the message code.
+    uint16_t level;                // TidyReportLevel.
+    uint16_t reserved;
+    uint32_t argumentsOffset;      // Location of the captured arguments in the list's arguments data.
+    uint32_t argumentsLength;
+} JSDTidyReportRecord;
+
+
+/**
+ *  @c JSDTidyMessageList is the array of @c JSDTidyMessage that
+ *  @c JSDTidyModel publishes as @c errorArray.
+ *
+ *  Reports are recorded as @c JSDTidyReportRecord in a contiguous buffer,
+ *  with their arguments in a second buffer. The @c JSDTidyMessage
+ *  instances are only created when they're requested from the array, and
+ *  they format their text only when it's read.
+ *
+ *  A list is built on a single thread, and shouldn't be modified once it
+ *  has been published. A published list may be read from any thread; its
+ *  messages are created under a lock.
+ */
+@interface JSDTidyMessageList : NSArray
+
+
+/**
+ *  Records a report from @b libtidy's report callback.
+ *
+ *  @param level The TidyReportLevel of the message.
+ *  @param line The line in the source text where the message occurs.
+ *  @param column The column number in @c line where the message occurs.
+ *  @param code The message code.
+ *  @param arguments A va_list of arguments, which will be consumed.
+ */
+- (void)addReportWithLevel:(TidyReportLevel)level
+                      line:(uint)line
+                    column:(uint)column
+                      code:(ctmbstr)code
+                 arguments:(va_list)arguments;
+
+/**
+ *  Indicates whether the receiver and @c otherList hold the same reports,
+ *  comparing the records and their arguments without formatting anything.
+ *  Any other kind of array is equal only if both are empty.
+ */
+- (BOOL)isEqualToMessageList:(NSArray *)otherList;
+
+/**
+ *  A 64-bit hash of the level, location, message code, and arguments of
+ *  the report at @c index, computed as the report was recorded.
+ */
+- (uint64_t)identityHashAtIndex:(NSUInteger)index;
+
+/**
+ *  Matches the receiver's reports against @c previousMessages by identity
+ *  hash. If @c previousMessages isn't a @c JSDTidyMessageList, all of its
+ *  messages are considered removed.
+ */
+- (JSDTidyMessageChanges *)changesFromMessages:(NSArray *)previousMessages;
+
+/**
+ *  Returns a new list with the same reports as the receiver, sharing the
+ *  receiver's storage but with its own messages. This lets a published
+ *  list be handed to another model, possibly on another thread, without
+ *  the two of them creating messages in the same list.
+ */
+- (JSDTidyMessageList *)listSharingReports;
+
+/**
+ *  The number of bytes used to store the reports.
+ */
+@property (nonatomic, assign, readonly) NSUInteger byteCount;
+
+/**
+ *  Initializes a list from an archive made by @c appendArchiveToData:,
+ *  possibly by another process.
+ *
+ *  @returns Returns the list, or @c nil if the archive isn't valid.
+ */
+- (instancetype)initWithArchive:(const uint8_t *)bytes length:(NSUInteger)length;
+
+/**
+ *  Appends an archive of the reports to @c data. Archives identify message
+ *  codes by name rather than by ordinal, so they can be read by any
+ *  process.
+ */
+- (void)appendArchiveToData:(NSMutableData *)data;
+
+
+@end
+
+
+/**
+ *  Creates messages for @c JSDTidyMessageList.
+ */
+@interface JSDTidyMessage ()
+
+/**
+ *  Initializes a message whose text is formatted from the captured
+ *  arguments when it's first read.
+ *
+ *  @param record The report.
+ *  @param arguments The data holding the arguments for @c record.
+ */
+- (instancetype)initWithRecord:(const JSDTidyReportRecord *)record
+                     arguments:(NSData *)arguments NS_DESIGNATED_INITIALIZER;
+
+@end
+
+
+/**
+ *  Creates changes for @c JSDTidyMessageList.
+ */
+@interface JSDTidyMessageChanges ()
+
+/**
+ *  @param previousMessages The messages that the changes are relative to.
+ *  @param previousIndexes For each new message, its index in
+ *    @c previousMessages or @c NSNotFound. Must be allocated with
+ *    @c malloc; the instance takes ownership. @c NULL reports every
+ *    message as changed.
+ *  @param count The number of new messages.
+ */
+- (instancetype)initWithPreviousMessages:(NSArray *)previousMessages
+                         previousIndexes:(NSUInteger *)previousIndexes
+                                   count:(NSUInteger)count;
+
+@end
@@ -0,0 +1,496 @@
+//
+//  JSDTidyMessageList.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyMessageList.h"
+#import "JSDTidyMessageFormat.h"
+#import "JSDTidyPlatform.h"
+
+
+#pragma mark - Implementation
+
+
+@implementation JSDTidyMessageList
+{
+    NSMutableData *_records;       // JSDTidyReportRecord, in report order.
+    NSMutableData *_arguments;     // Captured arguments for all of the records.
+    NSMutableData *_hashes;        // uint64_t identity hash of each record.
+    NSPointerArray *_messages;     // JSDTidyMessage instances, created on demand.
+    JSDTidyLock _lock;             // Protects _messages.
+}
+
+
+#pragma mark - Initialization
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - init
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)init
+{
+    if (self = [super init])
+    {
+        _records   = [[NSMutableData alloc] init];
+        _arguments = [[NSMutableData alloc] init];
+        _hashes    = [[NSMutableData alloc] init];
+        _messages  = [NSPointerArray strongObjectsPointerArray];
+        _lock      = JSDTidyLockInit;
+    }
+
+    return self;
+}
+
+
+#pragma mark - Recording
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - addReportWithLevel:line:column:code:arguments:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)addReportWithLevel:(TidyReportLevel)level
+                      line:(uint)line
+                    column:(uint)column
+                      code:(ctmbstr)code
+                 arguments:(va_list)arguments
+{
+    JSDTidyMessageFormat *format = [JSDTidyMessageFormat formatForCode:code];
+
+    JSDTidyReportRecord record;
+
+    record.line            = line;
+    record.column          = column;
+    record.ordinal         = format.ordinal;
+    record.level           = (uint16_t)level;
+    record.reserved        = 0;
+    record.argumentsOffset = (uint32_t)_arguments.length;
+
+    [format captureArguments:arguments intoData:_arguments];
+
+    record.argumentsLength = (uint32_t)(_arguments.length - record.argumentsOffset);
+
+    [self appendRecord:&record];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - appendRecord: (private)
+ *   Adds a record whose arguments are already in `_arguments`.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)appendRecord:(const JSDTidyReportRecord *)record
+{
+    [_records appendBytes:record length:sizeof(*record)];
+
+    /* The identity covers everything except where the arguments are. */
+
+    uint64_t hash = JSDTidyFNVHash(JSDTidyFNVHashSeed, record, offsetof(JSDTidyReportRecord, argumentsOffset));
+
+    hash = JSDTidyFNVHash(hash, (const uint8_t *)_arguments.bytes + record->argumentsOffset, record->argumentsLength);
+
+    [_hashes appendBytes:&hash length:sizeof(hash)];
+}
+
+
+#pragma mark - Archiving
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyMessageArchiveHeader
+ *   An archive is this header, then the message codes as C
+ *   strings back to back, then the records with their ordinals
+ *   replaced by indexes into the codes, then the arguments.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDTidyMessageArchiveHeader {
+    uint32_t recordCount;
+    uint32_t codeCount;
+    uint32_t codesLength;
+    uint32_t argumentsLength;
+} JSDTidyMessageArchiveHeader;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithArchive:length:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithArchive:(const uint8_t *)bytes length:(NSUInteger)length
+{
+    if (!(self = [self init]))
+    {
+        return nil;
+    }
+
+    JSDTidyMessageArchiveHeader header;
+
+    if (length < sizeof(header))
+    {
+        return nil;
+    }
+
+    memcpy(&header, bytes, sizeof(header));
+
+    NSUInteger recordsLength = (NSUInteger)header.recordCount * sizeof(JSDTidyReportRecord);
+
+    if (length != sizeof(header) + header.codesLength + recordsLength + header.argumentsLength)
+    {
+        return nil;
+    }
+
+    const char *codes = (const char *)bytes + sizeof(header);
+    const uint8_t *records = bytes + sizeof(header) + header.codesLength;
+    const uint8_t *arguments = records + recordsLength;
+
+
+    /* Map the codes back to this process's ordinals. */
+
+    uint32_t *ordinals = malloc(MAX(header.codeCount, 1) * sizeof(uint32_t));
+
+    if (!ordinals)
+    {
+        return nil;
+    }
+
+    const char *code = codes;
+    const char *codesEnd = codes + header.codesLength;
+
+    for (uint32_t i = 0; i < header.codeCount; i++)
+    {
+        size_t codeLength = code < codesEnd ? strnlen(code, (size_t)(codesEnd - code)) : 0;
+
+        if (code + codeLength >= codesEnd)
+        {
+            free(ordinals);
+            return nil;
+        }
+
+        NSString *codeString = [[NSString alloc] initWithBytes:code length:codeLength encoding:NSUTF8StringEncoding];
+
+        if (!codeString)
+        {
+            free(ordinals);
+            return nil;
+        }
+
+        ordinals[i] = [JSDTidyMessageFormat formatForCodeString:codeString].ordinal;
+        code += codeLength + 1;
+    }
+
+    [_arguments appendBytes:arguments length:header.argumentsLength];
+
+    for (uint32_t i = 0; i < header.recordCount; i++)
+    {
+        JSDTidyReportRecord record;
+
+        memcpy(&record, records + i * sizeof(record), sizeof(record));
+
+        if (record.ordinal >= header.codeCount ||
+            (uint64_t)record.argumentsOffset + record.argumentsLength > header.argumentsLength)
+        {
+            free(ordinals);
+            return nil;
+        }
+
+        record.ordinal = ordinals[record.ordinal];
+
+        [self appendRecord:&record];
+    }
+
+    free(ordinals);
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - appendArchiveToData:
+ *   Ordinals only last for the life of the process, so the codes
+ *   themselves are written, each only once.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)appendArchiveToData:(NSMutableData *)data
+{
+    NSUInteger count = self.count;
+    const JSDTidyReportRecord *records = _records.bytes;
+
+    NSMutableData *codes = [[NSMutableData alloc] init];
+    NSMutableData *archivedRecords = [[NSMutableData alloc] initWithCapacity:_records.length];
+    NSMutableDictionary<NSNumber *, NSNumber *> *codeIndexes = [[NSMutableDictionary alloc] init];
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        JSDTidyReportRecord record = records[i];
+        NSNumber *codeIndex = codeIndexes[@(record.ordinal)];
+
+        if (!codeIndex)
+        {
+            const char *code = [JSDTidyMessageFormat formatWithOrdinal:record.ordinal].code.UTF8String;
+
+            codeIndex = @(codeIndexes.count);
+            codeIndexes[@(record.ordinal)] = codeIndex;
+
+            [codes appendBytes:code length:strlen(code) + 1];
+        }
+
+        record.ordinal = codeIndex.unsignedIntValue;
+
+        [archivedRecords appendBytes:&record length:sizeof(record)];
+    }
+
+    JSDTidyMessageArchiveHeader header;
+
+    header.recordCount     = (uint32_t)count;
+    header.codeCount       = (uint32_t)codeIndexes.count;
+    header.codesLength     = (uint32_t)codes.length;
+    header.argumentsLength = (uint32_t)_arguments.length;
+
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:codes];
+    [data appendData:archivedRecords];
+    [data appendData:_arguments];
+}
+
+
+#pragma mark - NSArray Primitives
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - count
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)count
+{
+    return _records.length / sizeof(JSDTidyReportRecord);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - objectAtIndex:
+ *   A published list may be read from several threads at once, so
+ *   creating its messages is serialized.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (id)objectAtIndex:(NSUInteger)index
+{
+    NSUInteger count = self.count;
+
+    if (index >= count)
+    {
+        [NSException raise:NSRangeException format:@"Index %lu is beyond bounds [0 .. %lu].", (unsigned long)index, (unsigned long)count];
+    }
+
+    JSDTidyLockLock(&_lock);
+
+    if (_messages.count != count)
+    {
+        _messages.count = count;
+    }
+
+    JSDTidyMessage *message = [_messages pointerAtIndex:index];
+
+    if (!message)
+    {
+        const JSDTidyReportRecord *records = _records.bytes;
+
+        message = [[JSDTidyMessage alloc] initWithRecord:&records[index] arguments:_arguments];
+
+        [_messages replacePointerAtIndex:index withPointer:(__bridge void *)message];
+    }
+
+    JSDTidyLockUnlock(&_lock);
+
+    return message;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - copyWithZone:
+ *   Published lists are immutable.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - listSharingReports
+ *   The report buffers are never modified once a list has been
+ *   published, so they can be shared as is; only the messages,
+ *   which are created lazily, belong to each list.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyMessageList *)listSharingReports
+{
+    JSDTidyMessageList *list = [[JSDTidyMessageList alloc] init];
+
+    list->_records   = _records;
+    list->_arguments = _arguments;
+    list->_hashes    = _hashes;
+
+    return list;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @byteCount
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)byteCount
+{
+    return _records.length + _arguments.length + _hashes.length;
+}
+
+
+#pragma mark - Comparison
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - isEqualToMessageList:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)isEqualToMessageList:(NSArray *)otherList
+{
+    if (otherList == self)
+    {
+        return YES;
+    }
+
+    if (![otherList isKindOfClass:[JSDTidyMessageList class]])
+    {
+        return self.count == 0 && otherList.count == 0;
+    }
+
+    JSDTidyMessageList *other = (JSDTidyMessageList *)otherList;
+
+    if (other->_records == _records)
+    {
+        return YES;
+    }
+
+    NSUInteger count = self.count;
+
+    if (count != other.count)
+    {
+        return NO;
+    }
+
+    const JSDTidyReportRecord *records = _records.bytes;
+    const JSDTidyReportRecord *otherRecords = other->_records.bytes;
+    const uint8_t *arguments = _arguments.bytes;
+    const uint8_t *otherArguments = other->_arguments.bytes;
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        const JSDTidyReportRecord *a = &records[i];
+        const JSDTidyReportRecord *b = &otherRecords[i];
+
+        if (a->line != b->line || a->column != b->column || a->ordinal != b->ordinal ||
+            a->level != b->level || a->argumentsLength != b->argumentsLength)
+        {
+            return NO;
+        }
+
+        if (a->argumentsLength && memcmp(arguments + a->argumentsOffset, otherArguments + b->argumentsOffset, a->argumentsLength) != 0)
+        {
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - identityHashAtIndex:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (uint64_t)identityHashAtIndex:(NSUInteger)index
+{
+    return ((const uint64_t *)_hashes.bytes)[index];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - changesFromMessages:
+ *   The previous reports go into an open-addressed table by hash,
+ *   with reports sharing a hash chained in order, so each of our
+ *   reports is matched with the earliest unmatched identical one.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyMessageChanges *)changesFromMessages:(NSArray *)previousMessages
+{
+    NSUInteger count = self.count;
+    NSUInteger *previousIndexes = malloc(MAX(count, 1) * sizeof(NSUInteger));
+
+    /* Without memory to match them, every message is reported as changed. */
+
+    for (NSUInteger i = 0; previousIndexes && i < count; i++)
+    {
+        previousIndexes[i] = NSNotFound;
+    }
+
+    if (!previousIndexes || ![previousMessages isKindOfClass:[JSDTidyMessageList class]] || previousMessages.count == 0 || count == 0)
+    {
+        return [[JSDTidyMessageChanges alloc] initWithPreviousMessages:previousMessages previousIndexes:previousIndexes count:count];
+    }
+
+    JSDTidyMessageList *previous = (JSDTidyMessageList *)previousMessages;
+    NSUInteger previousCount = previous.count;
+    const uint64_t *previousHashes = previous->_hashes.bytes;
+    const uint64_t *hashes = _hashes.bytes;
+
+    typedef struct { uint64_t hash; NSUInteger head; BOOL occupied; } JSDHashSlot;
+
+    NSUInteger tableSize = 16;
+
+    while (tableSize < previousCount * 2)
+    {
+        tableSize *= 2;
+    }
+
+    JSDHashSlot *table = calloc(tableSize, sizeof(JSDHashSlot));
+    NSUInteger *next = malloc(previousCount * sizeof(NSUInteger));
+
+    if (!table || !next)
+    {
+        free(table);
+        free(next);
+
+        return [[JSDTidyMessageChanges alloc] initWithPreviousMessages:previousMessages previousIndexes:previousIndexes count:count];
+    }
+
+    /* Push in reverse, so that each chain is in ascending order. */
+
+    for (NSUInteger i = previousCount; i-- > 0;)
+    {
+        NSUInteger slot = (NSUInteger)previousHashes[i] & (tableSize - 1);
+
+        while (table[slot].occupied && table[slot].hash != previousHashes[i])
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        next[i] = table[slot].occupied ? table[slot].head : NSNotFound;
+        table[slot].hash = previousHashes[i];
+        table[slot].head = i;
+        table[slot].occupied = YES;
+    }
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        NSUInteger slot = (NSUInteger)hashes[i] & (tableSize - 1);
+
+        while (table[slot].occupied && table[slot].hash != hashes[i])
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        NSUInteger match = table[slot].occupied ? table[slot].head : NSNotFound;
+
+        if (match != NSNotFound)
+        {
+            previousIndexes[i] = match;
+            table[slot].head = next[match];
+        }
+    }
+
+    free(table);
+    free(next);
+
+    return [[JSDTidyMessageChanges alloc] initWithPreviousMessages:previousMessages previousIndexes:previousIndexes count:count];
+}
+
+
+@end
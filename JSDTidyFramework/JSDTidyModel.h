@@ -11,11 +11,71 @@
 //    [1]: http://www.html-tidy.org
 //
 
-@import Cocoa;
+@import Foundation;
+@import HTMLTidy;
 
 #import <JSDTidyFramework/JSDTidyModelDelegate.h>
 
 @class JSDTidyOption;
+@class JSDTidyModel;
+@class JSDTidyMessageChanges;
+@class JSDTidyOptionSet;
+@class JSDTidyResultCache;
+@class JSDTidyBatchResult;
+
+
+/**
+ *  The block type used by @c processTidyWithCompletionHandler:.
+ *
+ *  @param tidyModel The @c JSDTidyModel that performed the tidying, or
+ *    @c nil if it was deallocated before the run completed.
+ *  @param published Indicates whether the results of this request were
+ *    published to the model. Requests that are superseded by newer
+ *    requests (or cancelled) are not published.
+ */
+typedef void (^JSDTidyCompletionHandler)(JSDTidyModel *tidyModel, BOOL published);
+
+
+/**
+ *  The block type used by @c lintFilesAtURLs:withOptionSet:stopAfterReportCount:atReportLevel:resultHandler:.
+ *
+ *  @param fileURL The file that was linted.
+ *  @param result The result, whose @c errorArray, status properties, and
+ *    @c tidyStoppedEarly are those of a model that linted the file.
+ */
+typedef void (^JSDTidyLintResultHandler)(NSURL *fileURL, JSDTidyBatchResult *result);
+
+
+/** How much of its work @c JSDTidyModel does each time it tidies. */
+typedef NS_ENUM(NSUInteger, JSDTidyRunMode) {
+    JSDTidyRunModeComplete        = 0,   // Print the text and the error text right away.
+    JSDTidyRunModeDeferredOutput  = 1,   // Print the text when it's first read.
+    JSDTidyRunModeDiagnosticsOnly = 2,   // Only the messages, counts, and status.
+};
+
+
+/** Which of @c JSDTidyModel's budgets, if any, ended a tidying operation. */
+typedef NS_ENUM(NSUInteger, JSDTidyBudgetStatus) {
+    JSDTidyBudgetStatusWithinBudgets       = 0,
+    JSDTidyBudgetStatusTimeExceeded        = 1,   // timeBudget
+    JSDTidyBudgetStatusAllocationsExceeded = 2,   // allocationBudget
+    JSDTidyBudgetStatusMemoryExceeded      = 3,   // memoryBudget
+};
+
+
+/**
+ *  The output profiles understood by @c tidyTextsForOutputProfiles:.
+ *
+ *  @li @c JSDTidyOutputProfileDocument is the complete document.
+ *  @li @c JSDTidyOutputProfileBodyOnly is the content of the @c body
+ *    element only.
+ *  @li @c JSDTidyOutputProfileXHTML is the complete document as XHTML.
+ *  @li @c JSDTidyOutputProfileXML is the complete document as XML.
+ */
+#define JSDTidyOutputProfileDocument @"document"
+#define JSDTidyOutputProfileBodyOnly @"body-only"
+#define JSDTidyOutputProfileXHTML    @"xhtml"
+#define JSDTidyOutputProfileXML      @"xml"
 
 
 #pragma mark - class JSDTidyModel
@@ -207,6 +267,8 @@
  *  @c [JSDTidyModelDelegate @c tidyModelDetectedInputEncodingIssue:currentEncoding:suggestedEncoding:]
  *  message will be sent.
  *
+ *  The model keeps a copy of the bytes, so @c data may be memory mapped.
+ *
  *  @param data The @c NSData object containing the source text string.
  */
 - (void)setSourceTextWithData:(NSData *)data;
@@ -229,9 +291,21 @@
 
 /**
  *  The result of the tidying operation.
+ *
+ *  The string is created from @c tidyTextAsUTF8Data the first time that it
+ *  is requested after each tidying operation, so clients that only need
+ *  bytes never pay for a string conversion.
  */
 @property (nonatomic, strong, readonly) NSString *tidyText;
 
+/**
+ *  The result of the tidying operation exactly as @b libtidy produced it,
+ *  i.e., UTF-8 with @b LF line endings, regardless of the @b output-encoding
+ *  and @b newline Tidy options. The bytes are copied once from
+ *  @b libtidy's output buffer, which is kept for reuse by later runs.
+ */
+@property (nonatomic, strong, readonly) NSData *tidyTextAsUTF8Data;
+
 /**
  *  The result of the tidying operation, available as an @c NSData object,
  *  using the instance's current @b output-encoding Tidy option and the
@@ -251,6 +325,20 @@
  */
 - (void)tidyTextToFile:(NSString *)path;
 
+/**
+ *  Writes the result of the tidying operation to an open file descriptor,
+ *  using the instance's current @b output-encoding Tidy option and the
+ *  correct line endings per @b newline. When these are UTF-8 and @b LF,
+ *  the bytes are written straight from @c tidyTextAsUTF8Data.
+ *
+ *  The file descriptor is not closed.
+ *
+ *  @param fileDescriptor An open, writable file descriptor.
+ *
+ *  @return Returns YES on success, or NO if a write failed.
+ */
+- (BOOL)tidyTextToFileDescriptor:(int)fileDescriptor;
+
 /**
  *  Indicates whether or not @c sourceText is considered "dirty," meaning
  *  that @c sourceText has changed, or @c sourceText is not equal to
@@ -284,6 +372,14 @@
  */
 @property (nonatomic, strong, readonly) NSArray  *errorArray;
 
+/**
+ *  Describes how @c errorArray changed with the most recent tidying
+ *  operation that changed it, so that clients can update incrementally.
+ *  This is also provided with @c tidyNotifyTidyErrorsChanged and
+ *  @c [JSDTidyModelDelegate @c tidyModelTidyMessagesChanged:messages:changes:].
+ */
+@property (nonatomic, strong, readonly) JSDTidyMessageChanges *errorArrayChanges;
+
 
 #pragma mark - Options Overall Management
 
@@ -325,6 +421,35 @@
  */
 - (void)      optionsResetAllToBuiltInDefaults;
 
+/**
+ *  The effective values of all of the options in @c tidyOptions, as an
+ *  immutable @c JSDTidyOptionSet. Suppressed options have their built-in
+ *  defaults, because they're not applied.
+ *
+ *  Setting this property changes only the options whose values differ,
+ *  within a single @c beginOptionUpdates / @c commitOptionUpdates, so
+ *  copying options from one model to another is simply
+ *  @c otherModel.optionSet @c = @c model.optionSet.
+ */
+@property (nonatomic, copy) JSDTidyOptionSet *optionSet;
+
+/**
+ *  Begins a batch of option changes. Until the matching
+ *  @c commitOptionUpdates, setting options won't post
+ *  @c tidyNotifyOptionChanged, call the delegate, or cause tidying.
+ *  Updates can be nested; only the outermost commit takes effect.
+ */
+- (void)      beginOptionUpdates;
+
+/**
+ *  Ends a batch of option changes begun with @c beginOptionUpdates. If
+ *  the values of any options are different than they were when the batch
+ *  began, then a single @c tidyNotifyOptionChanged is posted, with the
+ *  names and new values of the changed options in its @c userInfo, and
+ *  the text is tidied once. If nothing changed, then nothing happens.
+ */
+- (void)      commitOptionUpdates;
+
 /**
  *  Sets the current Tidy options from a Tidy configuration file.
  *
@@ -376,6 +501,243 @@
 @property (nonatomic, strong) NSArray* optionsInUse;
 
 
+#pragma mark - Background Tidying
+
+
+/**
+ *  Indicates whether changes to the source text or options are tidied
+ *  synchronously on the calling thread (the default), or queued to be
+ *  tidied on a background serial queue.
+ *
+ *  When tidying in the background, each request is assigned a new
+ *  @c tidyGeneration. A queued request that has been superseded by a newer
+ *  one is skipped without parsing, and only the newest results are
+ *  published, all at once, on @c tidyResultQueue. Until then @c tidyText,
+ *  @c errorText, @c errorArray, and the status properties continue to
+ *  reflect the previously published run.
+ */
+@property (nonatomic, assign) BOOL tidyInBackground;
+
+/**
+ *  The queue on which background results are published, and upon which
+ *  the delegate, @c NSNotification's, and KVO for those results will fire.
+ *  The default is the main queue. Headless clients can specify any queue,
+ *  and so do not require a run loop.
+ */
+@property (nonatomic, strong) dispatch_queue_t tidyResultQueue;
+
+/**
+ *  The generation number of the most recent tidy request. It increases by
+ *  one with each request, and with each call to @c cancelPendingTidy.
+ */
+@property (nonatomic, assign, readonly) NSUInteger tidyGeneration;
+
+/**
+ *  Tidies the current source text with the current options in the
+ *  background, regardless of @c tidyInBackground.
+ *
+ *  The source text and options are captured at the time of the call, so
+ *  later changes do not affect this request.
+ *
+ *  @param completionHandler An optional block that will be called on
+ *    @c tidyResultQueue when the request has been resolved, whether or not
+ *    its results were published.
+ */
+- (void)processTidyWithCompletionHandler:(JSDTidyCompletionHandler)completionHandler;
+
+/**
+ *  Ensures that no queued or in-progress background request is published.
+ *  The most recently published results remain in place.
+ */
+- (void)cancelPendingTidy;
+
+/**
+ *  If a background request is outstanding, cancels it and tidies
+ *  synchronously instead, so that on return the results reflect the
+ *  current source text and options. Call this on the thread that owns the
+ *  model, e.g., before saving.
+ */
+- (void)finishPendingTidy;
+
+
+#pragma mark - Run Mode
+
+
+/**
+ *  Determines how much work is done each time the model tidies. The
+ *  default, @c JSDTidyRunModeComplete, prints the tidy text and the
+ *  @c errorText as soon as the source is tidied.
+ *
+ *  With @c JSDTidyRunModeDeferredOutput, the tidy text isn't printed until
+ *  @c tidyText, @c tidyTextAsUTF8Data, or @c tidyTextAsData is first read,
+ *  so callers that only look at the messages and status never pay for it.
+ *  Because the text isn't known until then, @c tidyNotifyTidyTextChanged
+ *  is sent every time the source is tidied.
+ *
+ *  With @c JSDTidyRunModeDiagnosticsOnly, the tidy text is never printed,
+ *  and @b libtidy doesn't format its messages and summary into
+ *  @c errorText; both are empty. @c errorArray and the status properties
+ *  are complete, so this is the mode for validators and lint passes.
+ *
+ *  Changing the mode tidies the source again.
+ */
+@property (nonatomic, assign) JSDTidyRunMode runMode;
+
+
+#pragma mark - Fail-Fast Linting
+
+
+/**
+ *  When this is greater than zero, parsing stops as soon as this many
+ *  reports at @c stopAtReportLevel have been made, which is all that a
+ *  lint pass needs to know whether a document is broken. Documents with
+ *  fewer reports are tidied in full. The default is zero, which never
+ *  stops. Changes take effect the next time the source is tidied.
+ */
+@property (nonatomic, assign) NSUInteger stopAfterReportCount;
+
+/**
+ *  The level of the reports that are counted for
+ *  @c stopAfterReportCount. Only reports at exactly this level are
+ *  counted. The default is @c TidyError.
+ */
+@property (nonatomic, assign) TidyReportLevel stopAtReportLevel;
+
+/**
+ *  Indicates whether parsing of the most recently published results was
+ *  stopped by @c stopAfterReportCount. When it was, the document wasn't
+ *  cleaned, repaired, or printed, so @c tidyText is empty, and
+ *  @c errorArray and the status properties describe only the part of
+ *  the document that was read. Results that were stopped aren't cached.
+ */
+@property (nonatomic, assign, readonly) BOOL tidyStoppedEarly;
+
+/**
+ *  Lints each of @c fileURLs with @c JSDTidyRunModeDiagnosticsOnly,
+ *  stopping each one at the given number of reports, on as many threads
+ *  as there are processors. This is a convenience for a
+ *  @c JSDTidyBatchProcessor so configured, and like it doesn't create any
+ *  models. This returns when all of the files have been linted.
+ *
+ *  @param fileURLs The files to lint.
+ *  @param optionSet The options to lint with.
+ *  @param count The value for @c stopAfterReportCount.
+ *  @param level The value for @c stopAtReportLevel.
+ *  @param resultHandler Called once for each file, on the thread that
+ *    linted it, so it must be safe to call concurrently.
+ */
++ (void)lintFilesAtURLs:(NSArray<NSURL *> *)fileURLs
+          withOptionSet:(JSDTidyOptionSet *)optionSet
+   stopAfterReportCount:(NSUInteger)count
+          atReportLevel:(TidyReportLevel)level
+          resultHandler:(JSDTidyLintResultHandler)resultHandler;
+
+
+#pragma mark - Resource Budgets
+
+
+/**
+ *  The most time, in seconds, that parsing, cleaning, and repairing a
+ *  document may take. The default is zero, meaning no limit.
+ *
+ *  Budgets exist so that a single hostile input (deeply nested unclosed
+ *  tables, millions of attributes) can't hold a thread or exhaust memory.
+ *  When any budget is exceeded, @b libtidy is abandoned immediately, and
+ *  the results are published with @c tidyBudgetStatus saying which
+ *  budget it was, a @c tidyStatus of -1, an empty @c tidyText and
+ *  @c errorText, and whatever messages were recorded up to that point.
+ *  Such results aren't cached. Changes take effect the next time the
+ *  source is tidied.
+ */
+@property (nonatomic, assign) NSTimeInterval timeBudget;
+
+/**
+ *  The most allocations that @b libtidy may make while parsing, cleaning,
+ *  and repairing a document. Each node and attribute of the document
+ *  takes at least one, so this bounds the size of the document tree. The
+ *  default is zero, meaning no limit. See @c timeBudget.
+ */
+@property (nonatomic, assign) NSUInteger allocationBudget;
+
+/**
+ *  The most memory, in bytes, that @b libtidy's allocator may hold at
+ *  once while parsing, cleaning, and repairing a document. Space that
+ *  @b libtidy frees still counts until the document is done. The default
+ *  is zero, meaning no limit. See @c timeBudget.
+ */
+@property (nonatomic, assign) NSUInteger memoryBudget;
+
+/**
+ *  Indicates which budget, if any, ended the tidying of the most recently
+ *  published results.
+ */
+@property (nonatomic, assign, readonly) JSDTidyBudgetStatus tidyBudgetStatus;
+
+
+#pragma mark - Result Caching
+
+
+/**
+ *  The cache that is consulted before each tidying operation, and that
+ *  receives the results of each operation that has to parse. The default
+ *  is @c [JSDTidyResultCache @c sharedCache]; set this to @c nil to always
+ *  parse.
+ */
+@property (nonatomic, strong) JSDTidyResultCache *resultCache;
+
+/**
+ *  Indicates whether the most recently published results came from
+ *  @c resultCache rather than from @b libtidy. When they did,
+ *  @c tidyAllocationCount and @c tidyAllocationPeakBytes are zero.
+ */
+@property (nonatomic, assign, readonly) BOOL tidyResultWasCached;
+
+/**
+ *  Indicates whether the most recently published results were made by
+ *  printing the previous run's repaired document again, because only
+ *  options for which @c [JSDTidyOption @c optionIsOutputOnly] is true had
+ *  changed. The model keeps the most recently repaired document for this
+ *  purpose. When they were, @c tidyAllocationCount and
+ *  @c tidyAllocationPeakBytes are zero.
+ */
+@property (nonatomic, assign, readonly) BOOL tidyResultWasReprinted;
+
+
+#pragma mark - Multiple Outputs
+
+
+/**
+ *  Tidies the source text with the current options, and returns the
+ *  tidy text for each of @c profiles, which are @c JSDTidyOutputProfile
+ *  names. Profiles that differ only in options for which
+ *  @c [JSDTidyOption @c optionIsOutputOnly] is true (such as the
+ *  document and body-only profiles) share a single parse, and are
+ *  simply printed more than once. The XHTML and XML profiles change how
+ *  the document is repaired, so they're parsed on their own.
+ *
+ *  This is done synchronously, and the model's published results and
+ *  notifications are unaffected. Each text is added to @c resultCache,
+ *  so a later request for the same source and options doesn't tidy.
+ *
+ *  @param profiles The names of the profiles to produce. Unknown names
+ *    are ignored.
+ *  @returns Returns a dictionary of tidy text keyed by profile name.
+ */
+- (NSDictionary<NSString *, NSString *> *)tidyTextsForOutputProfiles:(NSArray<NSString *> *)profiles;
+
+/**
+ *  Like @c tidyTextsForOutputProfiles:, but each variant of the output
+ *  is described by option values that are merged over the current
+ *  options.
+ *
+ *  @param optionValues A dictionary of option values, keyed by a name
+ *    for each variant. The option values are dictionaries of option
+ *    names and values, as for @c optionsCopyValuesFromDictionary:.
+ *  @returns Returns a dictionary of tidy text keyed by variant name.
+ */
+- (NSDictionary<NSString *, NSString *> *)tidyTextsForOptionValues:(NSDictionary<NSString *, NSDictionary *> *)optionValues;
+
+
 #pragma mark - Diagnostics and Repair
 
 
@@ -402,7 +764,8 @@
  *  Echoes @b libtidy's version of the same, indicating the document
  *  error status.
  *
- *  The value is 0 if there are no errors, 2 for doc errors, 1 for other.
+ *  The value is 0 if there are no errors, 2 for doc errors, 1 for other,
+ *  and -1 if a budget was exceeded; see @c tidyBudgetStatus.
  */
 @property (nonatomic, assign, readonly) int tidyStatus;
 
@@ -424,6 +787,19 @@
  */
 @property (nonatomic, assign, readonly) uint tidyAccessWarningCount;
 
+/**
+ *  The number of allocations that @b libtidy made during the most recent
+ *  tidy run. @c JSDTidyModel gives each run its own arena allocator, which
+ *  is released all at once when the run completes.
+ */
+@property (nonatomic, assign, readonly) NSUInteger tidyAllocationCount;
+
+/**
+ *  The largest number of bytes that @b libtidy had allocated at any one
+ *  time during the most recent tidy run.
+ */
+@property (nonatomic, assign, readonly) NSUInteger tidyAllocationPeakBytes;
+
 
 #pragma mark - Miscelleneous
 
@@ -9,12 +9,51 @@
 
 #import "JSDTidyCommonHeaders.h"
 #import "JSDTidyOption.h"
+#import "JSDTidyOptionSet.h"
 #import "JSDTidyMessage.h"
+#import "JSDTidyMessageList.h"
+#import "JSDTidyArena.h"
+#import "JSDTidyCachedResult.h"
+#import "JSDTidyRun.h"
+#import "JSDTidyBatchProcessor.h"
+#import "JSDTidyEncodingSniffer.h"
+#import "JSDTidyLineEndings.h"
+#import "JSDTidyPlatform.h"
+#import "JSDTidyTranscoder.h"
 
 #import "SWFSemanticVersion.h" // for version checking.
 
 @import HTMLTidy;
 
+#include <stdatomic.h>
+#include <unistd.h>
+
+
+#pragma mark - CATEGORY JSDTidyOptionSet (JSDTidyModel)
+
+
+/* Private JSDTidyOptionSet methods that the model uses to build its
+ * effective options.
+ */
+@interface JSDTidyOptionSet (JSDTidyModel)
+
++ (instancetype)optionSetWithTidyOptions:(NSArray *)options;
+
+@end
+
+
+#pragma mark - Definitions
+
+
+/* The number of idle entries that a pool will hold on to. */
+
+static const NSUInteger JSDTidyDocPoolCapacity = 2;
+
+
+/* The number of bytes read between checks of the deadline. */
+
+#define JSDTidyByteSourceCheckInterval ((size_t)64 * 1024)
+
 
 #pragma mark - CATEGORY JSDTidyModel ()
 
@@ -23,27 +62,29 @@
 
 /* Redefinitions for private read-write access. */
 
-@property (readwrite) NSMutableArray *errorArray;
+@property (readwrite) NSArray *errorArray;
 
-@property (readwrite) NSString *errorText;
+@property (readwrite) JSDTidyMessageChanges *errorArrayChanges;
 
-@property (readwrite) NSString *tidyText;
+@property (readwrite) NSString *errorText;
 
 @property (readwrite) NSDictionary *tidyOptions;
 
 
 /* Private properties. */
 
-@property (nonatomic, strong) NSMutableArray *errorArrayB;        // Internal error array.
-
 @property (nonatomic, strong) NSMutableDictionary * errorImages;  // Dictionary of error images.
 
 @property (nonatomic, strong) NSData *originalData;               // The original data loaded from a file.
 
+@property (nonatomic, strong) NSData *sourceDataUTF8;             // originalData, if it's UTF-8 and matches sourceText.
+
 @property (nonatomic, strong) NSArray *tidyOptionHeaders;         // Holds fake options that can be used as headers.
 
 @property (nonatomic, assign) BOOL sourceDidChange;               // Indicates whether _sourceText has changed.
 
+@property (nonatomic, strong) dispatch_queue_t tidyQueue;         // Serial queue for background tidying.
+
 @end
 
 
@@ -56,10 +97,23 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 
 
 @implementation JSDTidyModel
+{
+    _Atomic(NSUInteger) _tidyGeneration;  // Most recently requested run.
+    _Atomic(NSUInteger) _publishedGeneration;  // Most recently published run.
+    TidyDoc _tidyTemplate;                // TidyDoc holding the current option values.
+    JSDTidyDocPool *_tidyDocPool;         // Recycled TidyDocs and buffers for runs.
+    JSDTidyOptionSet *_tidyTemplateOptions;  // The options that _tidyTemplate was built with.
+    JSDTidyOptionSet *_optionSet;         // Cached effective options; nil when an option changes.
+    NSUInteger _optionUpdateDepth;        // Nesting level of beginOptionUpdates.
+    JSDTidyOptionSet *_optionUpdateSnapshot;  // Options when the outermost update began.
+    JSDTidyRun *_deferredRun;             // Published run whose output hasn't been printed yet.
+}
 
 #pragma mark - iVar Synthesis
 
 @synthesize optionsInUse    = _optionsInUse;
+@synthesize tidyText        = _tidyText;
+@synthesize tidyTextAsUTF8Data = _tidyTextAsUTF8Data;
 
 
 #pragma mark - Standard C Functions
@@ -71,14 +125,68 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
  *   this standard C function to handle the callback.
  *
  *   `tidyGetAppData` result will already contain a reference to
- *   `self` that we set via `tidySetAppData` during processing.
+ *   the JSDTidyRun that we set via `tidySetAppData` during
+ *   processing.
  *   Essentially we're calling
  *   [self errorFilterWithLocalization:Level:Line:Column:Message:Arguments]
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 
 BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col, ctmbstr code, va_list args )
 {
-    return [(__bridge JSDTidyModel*)tidyGetAppData(tdoc) errorFilterWithLocalization:tdoc Level:lvl Line:line Column:col Message:code Arguments:args];
+    /* Unretained, because checking the budgets can longjmp out of here. */
+    __unsafe_unretained JSDTidyRun *run = (__bridge JSDTidyRun*)tidyGetAppData(tdoc);
+
+    BOOL result = [run errorFilterWithLocalization:tdoc Level:lvl Line:line Column:col Message:code Arguments:args];
+
+    JSDTidyByteSource *source = run.parsingSource;
+
+    if (source && source->arena)
+    {
+        JSDTidyArenaCheckBudgets(source->arena);
+    }
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyByteSource callbacks (regular C-functions)
+ *   The getByte, ungetByte, and eof functions for a TidyInputSource
+ *   backed by a JSDTidyByteSource.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+
+static int JSDTidyByteSourceGetByte( void *sourceData )
+{
+    JSDTidyByteSource *source = sourceData;
+
+    if (source->stopped || source->position >= source->length)
+    {
+        return EndOfStream;
+    }
+
+    if (source->arena && (source->position % JSDTidyByteSourceCheckInterval) == 0)
+    {
+        JSDTidyArenaCheckBudgets(source->arena);
+    }
+
+    return source->bytes[source->position++];
+}
+
+static void JSDTidyByteSourceUngetByte( void *sourceData, byte bv )
+{
+    JSDTidyByteSource *source = sourceData;
+
+    if (source->position > 0)
+    {
+        source->position--;
+    }
+}
+
+static Bool JSDTidyByteSourceIsEOF( void *sourceData )
+{
+    JSDTidyByteSource *source = sourceData;
+
+    return (source->stopped || source->position >= source->length) ? yes : no;
 }
 
 
@@ -96,12 +204,27 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
         _originalData      = nil;
         _sourceText        = @"";
         _tidyText          = @"";
+        _tidyTextAsUTF8Data = [[NSData alloc] init];
         _errorText         = @"";
         _tidyOptions       = [[NSDictionary alloc] init];
         _tidyOptionHeaders = [[NSArray alloc] init];
-        _errorArray        = [[NSMutableArray alloc] init];
-        _errorArrayB       = nil;
+        _errorArray        = [[JSDTidyMessageList alloc] init];
         _errorImages       = [[NSMutableDictionary alloc] init];
+        _tidyInBackground  = NO;
+        _tidyResultQueue   = dispatch_get_main_queue();
+        _tidyQueue         = dispatch_queue_create("com.balthisar.JSDTidyModel.tidy", DISPATCH_QUEUE_SERIAL);
+
+        atomic_init(&_tidyGeneration, 0);
+        atomic_init(&_publishedGeneration, 0);
+        _tidyTemplate        = NULL;
+        _tidyDocPool         = [[JSDTidyDocPool alloc] init];
+        _tidyTemplateOptions = nil;
+        _optionSet           = nil;
+        _resultCache         = [JSDTidyResultCache sharedCache];
+        _runMode             = JSDTidyRunModeComplete;
+        _stopAfterReportCount = 0;
+        _stopAtReportLevel   = TidyError;
+        _deferredRun         = nil;
 
         [self optionsPopulateTidyOptions];
     }
@@ -110,6 +233,18 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 }
 
 
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - dealloc
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)dealloc
+{
+    if (_tidyTemplate)
+    {
+        tidyRelease(_tidyTemplate);
+    }
+}
+
+
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * - initWithString:
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
@@ -235,22 +370,30 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - checkSourceCoding: (private)
+ * - checkSourceCoding:decodedLength: (private)
  *    Checks the passed-in data to perform a sanity check versus
  *    the current input-encoding. Returns suggested encoding,
  *    and if the current input-encoding is okay, returns that.
+ *
+ *    The caller has already decoded the data, so only data that
+ *    failed to decode are examined further, and then only by
+ *    sniffing the bytes rather than by decoding them again.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (NSStringEncoding)checkSourceCoding:(NSData*)data
+- (NSStringEncoding)checkSourceCoding:(NSData*)data decodedLength:(NSUInteger)decodedLength
 {
-    if (data)
+    if ( (data.length > 0) && (decodedLength < 1) )
     {
-        NSUInteger dataSize = data.length;
-        NSUInteger stringSize = [[[NSString alloc] initWithData:data encoding:self.inputEncoding] length];
+        JSDTidyEncodingCandidate candidates[JSDTidyEncodingMaxCandidates];
+        NSUInteger count = JSDTidySniffEncodings(data.bytes, data.length, candidates);
 
-        if ( (dataSize > 0) && (stringSize < 1) )
+        /* The best candidate that isn't the encoding that just failed. */
+
+        for (NSUInteger i = 0; i < count; i++)
         {
-            NSStringEncoding result = [NSString stringEncodingForData:data encodingOptions:nil convertedString:nil usedLossyConversion:nil];
-            return result;
+            if (candidates[i].encoding != self.inputEncoding)
+            {
+                return candidates[i].encoding;
+            }
         }
     }
 
@@ -282,6 +425,8 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 - (void)setSourceText:(NSString *)value
 {
     _sourceText = [self normalizeLineEndings:value];
+
+    self.sourceDataUTF8 = nil;
     
     if (!self.originalData)
     {
@@ -341,9 +486,14 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
          * the use of JSDTidyFramework in a text editor so:
          * the `self.originalData` is set only once; text changes set
          * via NSString will not overwrite the original data.
+         *
+         * The data may be memory mapped, and every re-tidy reads from
+         * `self.originalData` again, so keep bytes of our own. A mapped
+         * file that's truncated or rewritten in place would otherwise
+         * crash us with SIGBUS.
          */
         
-        self.originalData = [[NSData alloc] initWithData:data];
+        self.originalData = data ? [[NSData alloc] initWithBytes:data.bytes length:data.length] : nil;
     }
     
     /* It's possible that the _inputEncoding (chosen by the user) is
@@ -352,21 +502,40 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
      * decode the string with the user's preference.
      */
     
-    NSMutableString *testText = nil;
+    NSString *testText = nil;
 
     [self willChangeValueForKey:@"sourceText"];
 
-    if ((testText = [[NSMutableString alloc] initWithData:data encoding:self.inputEncoding] ))
+    if (self.inputEncoding == NSUTF8StringEncoding)
+    {
+        /* Normalize the bytes before decoding, so that the text is
+         * only converted once. Data without a CR is decoded as-is.
+         */
+        testText = [self stringByNormalizingUTF8Bytes:data.bytes length:data.length];
+    }
+    else if ((testText = [[NSString alloc] initWithData:data encoding:self.inputEncoding] ))
+    {
+        testText = [self normalizeLineEndings:testText];
+    }
+
+    _sourceText = testText ? testText : @"";
+
+    /* UTF-8 data can be given to libtidy as-is. libtidy does its own
+     * line ending normalization, so the result is the same as parsing
+     * `_sourceText`, without the copy.
+     */
+
+    if (testText && self.inputEncoding == NSUTF8StringEncoding)
     {
-        _sourceText = [self normalizeLineEndings:testText];
+        self.sourceDataUTF8 = self.originalData;
     }
     else
     {
-        _sourceText = @"";
+        self.sourceDataUTF8 = nil;
     }
 
     /* Sanity check the input-encoding */
-    NSStringEncoding suggestedEncoding = [self checkSourceCoding:data];
+    NSStringEncoding suggestedEncoding = [self checkSourceCoding:data decodedLength:_sourceText.length];
 
     if (suggestedEncoding != self.inputEncoding)
     {
@@ -387,12 +556,85 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (void)setSourceTextWithFile:(NSString *)path
 {
-    [self setSourceTextWithData:[NSData dataWithContentsOfFile:path]];
+    /* The mapping is only read while the bytes are copied; see
+     * setSourceTextWithData:.
+     */
+    [self setSourceTextWithData:[NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil]];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @tidyText
+ *   Created on demand from the UTF-8 bytes of the latest run.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)tidyText
+{
+    if (!_tidyText)
+    {
+        _tidyText = [[NSString alloc] initWithData:self.tidyTextAsUTF8Data encoding:NSUTF8StringEncoding];
+
+        if (!_tidyText)
+        {
+            _tidyText = @"";
+        }
+    }
+
+    return _tidyText;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @tidyTextAsUTF8Data
+ *   In JSDTidyRunModeDeferredOutput, the published run's text is
+ *   printed the first time that it's asked for.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (NSSet *)keyPathsForValuesAffectingTidyTextAsUTF8Data
+{
+    return [NSSet setWithArray:@[ @"tidyText" ]];
+}
+- (NSData *)tidyTextAsUTF8Data
+{
+    if (!_tidyTextAsUTF8Data)
+    {
+        JSDTidyRun *run = _deferredRun;
+
+        _deferredRun = nil;
+
+        if (run)
+        {
+            _tidyTextAsUTF8Data = [self tidyDataForOptionSets:@{ @"tidyText" : run.options }
+                                                   sourceText:run.sourceText
+                                                   sourceData:run.sourceData][@"tidyText"];
+        }
+
+        if (!_tidyTextAsUTF8Data)
+        {
+            _tidyTextAsUTF8Data = [[NSData alloc] init];
+        }
+    }
+
+    return _tidyTextAsUTF8Data;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @outputLineEnding (private)
+ *   Shortcut to expose the newline value. Runs always have libtidy
+ *   write LF; this is the line ending to use when saving.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (TidyLineEnding)outputLineEnding
+{
+    JSDTidyOption *localOption = self.tidyOptions[@"newline"];
+
+    return (TidyLineEnding)[localOption.optionValue integerValue];
 }
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * @tidyTextAsData
+ *   When the output is UTF-8 with LF, this is simply libtidy's
+ *   buffer. Common encodings are produced from the buffer in a
+ *   single pass; anything else goes through NSString.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 + (NSSet *)keyPathsForValuesAffectingTidyTextAsData
 {
@@ -400,20 +642,34 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 }
 - (NSData *)tidyTextAsData
 {
-    NSMutableString *testText = [[NSMutableString alloc] initWithString:self.tidyText];
+    TidyLineEnding lineEnding = [self outputLineEnding];
 
-    JSDTidyOption *localOption = self.tidyOptions[@"newline"];
+    NSStringEncoding encoding = self.outputEncoding;
+    NSData *utf8Data = self.tidyTextAsUTF8Data;
+
+    if (encoding == NSUTF8StringEncoding && lineEnding == TidyLF)
+    {
+        return utf8Data;
+    }
 
-    if ([localOption.optionConfigString isEqualToString:@"CR"])
+    if (JSDTidyTranscoderSupportsEncoding(encoding))
     {
-        [testText replaceOccurrencesOfString:@"\n" withString:@"\r" options:NSLiteralSearch range:NSMakeRange(0, [testText length])];
+        return JSDTidyTranscodeUTF8(utf8Data.bytes, utf8Data.length, encoding, lineEnding);
     }
-    else if ([localOption.optionConfigString isEqualToString:@"CRLF"])
+
+    /* Other encodings: expand the newlines into UTF-8 first, which is
+     * still only one pass, and let NSString do the encoding.
+     */
+
+    if (lineEnding == TidyLF)
     {
-        [testText replaceOccurrencesOfString:@"\n" withString:@"\r\n" options:NSLiteralSearch range:NSMakeRange(0, [testText length])];
+        return [self.tidyText dataUsingEncoding:encoding];
     }
 
-    return [testText dataUsingEncoding:self.outputEncoding];
+    NSData *expanded = JSDTidyTranscodeUTF8(utf8Data.bytes, utf8Data.length, NSUTF8StringEncoding, lineEnding);
+    NSString *expandedText = [[NSString alloc] initWithData:expanded encoding:NSUTF8StringEncoding];
+
+    return [expandedText dataUsingEncoding:encoding];
 }
 
 
@@ -422,7 +678,39 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (void)tidyTextToFile:(NSString *)path
 {
-    [[self.tidyText dataUsingEncoding:self.outputEncoding] writeToFile:path atomically:YES];
+    [self.tidyTextAsData writeToFile:path atomically:YES];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyTextToFileDescriptor:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)tidyTextToFileDescriptor:(int)fileDescriptor
+{
+    NSData *data = self.tidyTextAsData;
+
+    const uint8_t *bytes = data.bytes;
+    size_t remaining = data.length;
+
+    while (remaining > 0)
+    {
+        ssize_t written = write(fileDescriptor, bytes, remaining);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return NO;
+        }
+
+        bytes += written;
+        remaining -= (size_t)written;
+    }
+
+    return YES;
 }
 
 
@@ -439,16 +727,73 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
  * - normalizeLineEndings: (private)
  *    Ensure that we're using modern macOS line endings, regardless of
  *    source line endings. We will check for `newline` upon file save.
+ *    Text without a CR (i.e., nearly every keystroke) is returned
+ *    without any conversion at all.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (NSString *)normalizeLineEndings:(NSString*)text
 {
-    NSMutableString *localText = [NSMutableString stringWithString:text];
+    if ([text rangeOfString:@"\r" options:NSLiteralSearch].location == NSNotFound)
+    {
+        return [text copy];
+    }
+
+    NSUInteger length = [text lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    uint8_t *bytes = malloc(length);
+    NSUInteger usedLength = 0;
+
+    if (!bytes)
+    {
+        return [text copy];
+    }
+
+    [text getBytes:bytes maxLength:length usedLength:&usedLength encoding:NSUTF8StringEncoding options:0 range:NSMakeRange(0, text.length) remainingRange:NULL];
+
+    usedLength = JSDLineEndingsNormalize(bytes, usedLength);
+
+    NSString *result = [[NSString alloc] initWithBytesNoCopy:bytes length:usedLength encoding:NSUTF8StringEncoding freeWhenDone:YES];
+
+    if (!result)
+    {
+        free(bytes);
+        result = [text copy];
+    }
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - stringByNormalizingUTF8Bytes:length: (private)
+ *    Decodes UTF-8 bytes into a string with LF line endings. The
+ *    bytes are only copied if they contain a CR. Returns nil if the
+ *    bytes aren't valid UTF-8.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)stringByNormalizingUTF8Bytes:(const void *)bytes length:(NSUInteger)length
+{
+    if (JSDLineEndingsFindCR(bytes, length) == length)
+    {
+        return [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    }
+
+    uint8_t *localBytes = malloc(length);
+
+    if (!localBytes)
+    {
+        return nil;
+    }
+
+    memcpy(localBytes, bytes, length);
 
-    [localText replaceOccurrencesOfString:@"\r\n" withString:@"\n" options:NSLiteralSearch range:NSMakeRange(0, [localText length])];
+    NSUInteger localLength = JSDLineEndingsNormalize(localBytes, length);
 
-    [localText replaceOccurrencesOfString:@"\r" withString:@"\n" options:NSLiteralSearch range:NSMakeRange(0, [localText length])];
+    NSString *result = [[NSString alloc] initWithBytesNoCopy:localBytes length:localLength encoding:NSUTF8StringEncoding freeWhenDone:YES];
 
-    return localText;
+    if (!result)
+    {
+        free(localBytes);
+    }
+
+    return result;
 }
 
 
@@ -470,9 +815,9 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 + (NSArray *)optionsBuiltInOptionList
 {
     static NSMutableArray *optionsArray = nil;
-    
-    if (!optionsArray)
-    {
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
         optionsArray = [[NSMutableArray alloc] init];
         
         TidyDoc dummyDoc = tidyCreate();
@@ -490,7 +835,7 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
         }
 
         tidyRelease(dummyDoc);
-    }
+    });
     
     return optionsArray;
 }
@@ -501,82 +846,161 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (void)optionsCopyValuesFromModel:(JSDTidyModel *)theModel
 {
-    JSDTidyOption *foreignOption;
+    self.optionSet = theModel.optionSet;
+}
 
-    for (JSDTidyOption *localOption in [self.tidyOptions allValues])
-    {
-        foreignOption = theModel.tidyOptions[localOption.name];
 
-        localOption.optionValue = foreignOption.optionValue;
-    }
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - optionsCopyValuesFromDictionary:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)optionsCopyValuesFromDictionary:(NSDictionary *)theDictionary
+{
+    self.optionSet = [self.optionSet optionSetByMergingDictionary:theDictionary];
+}
 
-    [self notifyTidyModelOptionChanged:nil];
 
-    [self processTidy];
-    
-    [self fixSourceCoding];
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - optionsResetAllToBuiltInDefaults
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)optionsResetAllToBuiltInDefaults
+{
+    self.optionSet = [JSDTidyOptionSet optionSetWithBuiltInDefaults];
 }
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - optionsCopyValuesFromDictionary:
+ * @optionSet
+ *    Built from the options when it's first needed after a change,
+ *    and then shared by every run until an option changes again.
+ *    Setting it only touches the options whose values differ.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (void)optionsCopyValuesFromDictionary:(NSDictionary *)theDictionary
+- (JSDTidyOptionSet *)optionSet
 {
-    NSString *dictionaryValue;
+    if (!_optionSet)
+    {
+        _optionSet = [JSDTidyOptionSet optionSetWithTidyOptions:[self.tidyOptions allValues]];
+    }
 
-    for (JSDTidyOption *localOption in [self.tidyOptions allValues])
+    return _optionSet;
+}
+
+- (void)setOptionSet:(JSDTidyOptionSet *)optionSet
+{
+    NSArray *changedNames = [optionSet optionNamesDifferingFromOptionSet:self.optionSet];
+
+    if (changedNames.count == 0)
     {
-        if ((dictionaryValue = [theDictionary valueForKey:localOption.name]))
-        {
-            localOption.optionValue = dictionaryValue;
-        }
+        return;
     }
 
-    [self notifyTidyModelOptionChanged:nil];
+    [self beginOptionUpdates];
 
-    [self processTidy];
-    
-    [self fixSourceCoding];
+    for (NSString *optionName in changedNames)
+    {
+        JSDTidyOption *localOption = self.tidyOptions[optionName];
+
+        localOption.optionValue = [optionSet valueForOptionName:optionName];
+    }
+
+    [self commitOptionUpdates];
 }
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - optionsResetAllToBuiltInDefaults
+ * - beginOptionUpdates
+ *    Only the outermost update takes a snapshot of the option
+ *    values; nested updates simply join it.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (void)optionsResetAllToBuiltInDefaults
+- (void)beginOptionUpdates
 {
-    for (JSDTidyOption *localOption in self.tidyOptions)
+    if (_optionUpdateDepth++ == 0)
     {
-        localOption.optionValue = localOption.builtInDefaultValue;
+        _optionUpdateSnapshot = self.optionSet;
     }
+}
 
-    [self notifyTidyModelOptionChanged:nil];
 
-    [self processTidy];
-    
-    [self fixSourceCoding];
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - commitOptionUpdates
+ *    Options that were set to the value they already had don't
+ *    count as changes. If anything did change, then there's one
+ *    notification for all of the changes, and one tidy: if the
+ *    input-encoding changed, fixing the source coding does the
+ *    tidying, and otherwise we process it ourselves.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)commitOptionUpdates
+{
+    if (_optionUpdateDepth == 0)
+    {
+        NSLog(@"%@", @"WARNING: commitOptionUpdates called without beginOptionUpdates.");
+        return;
+    }
+
+    if (--_optionUpdateDepth > 0)
+    {
+        return;
+    }
+
+    NSMutableDictionary *changes = [[NSMutableDictionary alloc] init];
+
+    for (NSString *optionName in [self.optionSet optionNamesDifferingFromOptionSet:_optionUpdateSnapshot])
+    {
+        JSDTidyOption *localOption = self.tidyOptions[optionName];
+
+        changes[optionName] = localOption.optionValue;
+    }
+
+    _optionUpdateSnapshot = nil;
+
+    if (changes.count == 0)
+    {
+        return;
+    }
+
+    [self notifyTidyModelOptionChanged:nil values:changes];
+
+    if (changes[@"input-encoding"] && self.originalData && !self.sourceDidChange)
+    {
+        [self fixSourceCoding];
+    }
+    else
+    {
+        [self processTidy];
+    }
 }
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * - optionsTidyLoadConfig:
+ *    Only the options that the user could set are taken from the
+ *    file. The loaded set has built-in defaults for the encodings
+ *    and for read-only options, and suppressed options aren't the
+ *    user's to change, so all of those keep their current values.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (BOOL)optionsTidyLoadConfig:(NSURL *)fileURL;
 {
-    const char *configFile = [fileURL fileSystemRepresentation];
-    TidyDoc newTidy = tidyCreate();
-    int status = tidyLoadConfig( newTidy, configFile );
-    
-    if ( status == 0 )
+    JSDTidyOptionSet *loadedOptions = [JSDTidyOptionSet optionSetWithConfigFile:fileURL];
+
+    if ( loadedOptions )
     {
-        [self willChangeValueForKey:@"tidyOptionsBindable"];
-        
-        for (JSDTidyOption *option in [self.tidyOptions allValues])
+        NSMutableDictionary *loadedValues = [[NSMutableDictionary alloc] init];
+
+        for (NSString *optionName in [loadedOptions optionNamesDifferingFromOptionSet:self.optionSet])
         {
-            [option setOptionFromTidyDoc:newTidy];
+            JSDTidyOption *localOption = self.tidyOptions[optionName];
+
+            if (localOption.optionIsSuppressed || localOption.optionIsReadOnly || localOption.optionIsEncodingOption)
+            {
+                continue;
+            }
+
+            loadedValues[optionName] = [loadedOptions valueForOptionName:optionName];
         }
+
+        [self willChangeValueForKey:@"tidyOptionsBindable"];
         
+        self.optionSet = [self.optionSet optionSetByMergingDictionary:loadedValues];
+
         [self didChangeValueForKey:@"tidyOptionsBindable"];
       
         return YES;
@@ -585,7 +1009,6 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
     {
         return NO;
     }
-    
 }
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
@@ -607,6 +1030,9 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 
     _optionsInUse = options;
 
+    /* Suppressed options aren't applied, so the effective options change. */
+    _optionSet = nil;
+
     for (JSDTidyOption *localOption in [self.tidyOptions allValues])
     {
         if (_optionsInUse)
@@ -700,137 +1126,259 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - processTidy (private)
- *    Processes the current `sourceText` into `tidyText`.
- *    This is action takes place in the background and works quite
- *    well for GUI applications that wait for notifications that
- *    `tidyText` has been changed.
+ * @runMode
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (void)processTidy
+- (void)setRunMode:(JSDTidyRunMode)runMode
 {
-    /* Create a TidyDoc and sets its options. */
-
-    TidyDoc newTidy = tidyCreate();
+    if (runMode != _runMode)
+    {
+        _runMode = runMode;
 
-    /* Force the library to use its default localization! Otherwise we will
-     * get Tidy's localized strings instead of our own.
-     */
+        [self processTidy];
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @tidyGeneration
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)tidyGeneration
+{
+    return atomic_load(&_tidyGeneration);
+}
 
-    tidySetLanguage( "en" );
 
-    /* Capture the array locally. */
-    NSArray *localOptions = [[NSArray alloc] initWithArray:[self.tidyOptions allValues]];
-    for (JSDTidyOption *localOption in localOptions)
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - processTidy (private)
+ *    Processes the current `sourceText` into `tidyText`. Unless
+ *    `tidyInBackground` is set, this takes place synchronously on
+ *    the calling thread.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)processTidy
+{
+    if (self.tidyInBackground)
     {
-        [localOption applyOptionToTidyDoc:newTidy];
+        [self processTidyWithCompletionHandler:nil];
+        return;
     }
 
+    NSUInteger generation = atomic_fetch_add(&_tidyGeneration, 1) + 1;
 
-    /* Setup the `outBuffer` to copy later to an NSString instead of writing
-     * to stdout
-     */
+    JSDTidyRun *run = [self tidyRunPrepare:generation];
 
-    TidyBuffer *outBuffer = malloc(sizeof(TidyBuffer));
-    tidyBufInit( outBuffer );
+    [run execute];
 
+    [self tidyRunPublish:run];
+}
 
-    /* Setup for using and out-of-class C function as a callback
-     * from libtidy in order to collect cleanup and diagnostic
-     * information. The C function is defined near the top of
-     * this file.
-     */
-    tidySetAppData(newTidy, (__bridge void *)(self));
 
-    tidySetReportCallback(newTidy, (TidyReportCallback)&tidyReportCallback);
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - processTidyWithCompletionHandler:
+ *    The source text and options are captured now, and the run is
+ *    queued on our serial `tidyQueue`. Runs that have been
+ *    superseded by a newer request by the time they're dequeued
+ *    are skipped, and results are only published if they're still
+ *    the newest when they arrive on `tidyResultQueue`.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)processTidyWithCompletionHandler:(JSDTidyCompletionHandler)completionHandler
+{
+    NSUInteger generation = atomic_fetch_add(&_tidyGeneration, 1) + 1;
 
+    JSDTidyRun *run = [self tidyRunPrepare:generation];
 
-    /* Setup the error buffer to catch errors here instead of stdout */
+    dispatch_queue_t resultQueue = self.tidyResultQueue ?: dispatch_get_main_queue();
 
-    TidyBuffer *errBuffer = malloc(sizeof(TidyBuffer));
-    tidyBufInit(errBuffer);
-    tidySetErrorBuffer(newTidy, errBuffer);
+    __weak JSDTidyModel *weakSelf = self;
 
+    dispatch_async(self.tidyQueue, ^{
 
-    /* Clear out all of the previous errors from our collection. */
+        JSDTidyModel *strongSelf = weakSelf;
 
-    self.errorArrayB = [[NSMutableArray alloc] init];
+        /* Coalesce: if a newer request has already been made, then this
+         * one's results would be thrown away anyway, so don't parse.
+         */
+        if (strongSelf && (strongSelf.tidyGeneration == generation))
+        {
+            [run execute];
+        }
 
+        dispatch_async(resultQueue, ^{
 
-    /* Setup tidy to use UTF8 for all internal operations. */
+            BOOL published = NO;
 
-    tidyOptSetValue(newTidy, TidyCharEncoding, [@"utf8" UTF8String]);
-    tidyOptSetValue(newTidy, TidyInCharEncoding, [@"utf8" UTF8String]);
-    tidyOptSetValue(newTidy, TidyOutCharEncoding, [@"utf8" UTF8String]);
+            if (strongSelf && (strongSelf.tidyGeneration == generation))
+            {
+                [strongSelf tidyRunPublish:run];
+                published = YES;
+            }
 
+            if (completionHandler)
+            {
+                completionHandler(strongSelf, published);
+            }
+        });
+    });
+}
 
-    /* Parse the `_sourceText` and clean, repair, and diagnose it. */
 
-    tidyParseString(newTidy, [self.sourceText UTF8String]);
-    tidyCleanAndRepair(newTidy);
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - cancelPendingTidy
+ *    Bumping the generation makes every queued or executing run
+ *    stale, so none of them will be published.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)cancelPendingTidy
+{
+    atomic_fetch_add(&_tidyGeneration, 1);
+}
 
-    /* Not needed, unless LibTidy formalizes its footnotes support. */
-//    tidyRunDiagnostics(newTidy);
 
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - finishPendingTidy
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)finishPendingTidy
+{
+    if (self.tidyGeneration != atomic_load(&_publishedGeneration))
+    {
+        NSUInteger generation = atomic_fetch_add(&_tidyGeneration, 1) + 1;
 
-    /* Write additional information to the error output sink.
-     * Note that this information is NOT captured in the error filter.
-     */
-    tidyErrorSummary(newTidy);
-    tidyGeneralInfo(newTidy);
+        JSDTidyRun *run = [self tidyRunPrepare:generation];
 
+        [run execute];
 
-    /* Set ivars for properties. */
+        [self tidyRunPublish:run];
+    }
+}
 
-    _tidyDetectedHtmlVersion = tidyDetectedHtmlVersion(newTidy);
-    _tidyDetectedXhtml       = tidyDetectedXhtml(newTidy);
-    _tidyDetectedGenericXml  = tidyDetectedGenericXml(newTidy);
-    _tidyStatus              = tidyStatus(newTidy);
-    _tidyErrorCount          = tidyErrorCount(newTidy);
-    _tidyWarningCount        = tidyWarningCount(newTidy);
-    _tidyAccessWarningCount  = tidyAccessWarningCount(newTidy);
 
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyRunPrepare: (private)
+ *    Creates a JSDTidyRun containing a TidyDoc configured with the
+ *    current options, and a snapshot of the current source text.
+ *    This must be called on the thread that owns the model.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyRun *)tidyRunPrepare:(NSUInteger)generation
+{
+    /* Get a TidyDoc from the pool and copy its options from the
+     * template in a single step.
+     */
 
-    /* Copy the error buffer into an NSString. */
+    JSDTidyDocEntry *entry = [_tidyDocPool checkOut];
 
-    if (errBuffer->size > 0)
-    {
-        self.errorText = [[NSString alloc] initWithUTF8String:(char *)errBuffer->bp];
-    }
-    else
-    {
-        self.errorText = @"";
-    }
+    tidyOptCopyConfig( entry->tidyDoc, [self tidyTemplate] );
+
+    JSDTidyRun *run = [[JSDTidyRun alloc] init];
 
+    run.generation = generation;
+    run.sourceText = [self.sourceText copy];
+    run.sourceData = self.sourceDataUTF8;
+    run.entry      = entry;
+    run.pool       = _tidyDocPool;
+    run.cache      = self.resultCache;
+    run.runMode    = self.runMode;
 
-    /* Save the tidy'd text to an NSString. */
+    run.stopAfterReportCount = self.stopAfterReportCount;
+    run.stopAtReportLevel    = self.stopAtReportLevel;
+    run.timeBudget           = self.timeBudget;
+    run.allocationBudget     = self.allocationBudget;
+    run.memoryBudget         = self.memoryBudget;
 
-    NSString *tidyResult;
+    /* The template was just brought up to date, so its options are the
+     * ones that the run's TidyDoc has.
+     */
+    run.options = _tidyTemplateOptions;
+
+    return run;
+}
 
-    tidySaveBuffer(newTidy, outBuffer);
 
-    if (outBuffer->size > 0)
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyTemplate (private)
+ *    Returns a TidyDoc that has all of our options applied. It's
+ *    only rebuilt when the effective options are different than
+ *    the last time it was built; otherwise each run simply copies
+ *    its config.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (TidyDoc)tidyTemplate
+{
+    JSDTidyOptionSet *options = self.optionSet;
+
+    if (!_tidyTemplate || ![options isEqualToOptionSet:_tidyTemplateOptions])
     {
-        tidyResult = [[NSString alloc] initWithUTF8String:(char *)outBuffer->bp];
+        if (_tidyTemplate)
+        {
+            tidyRelease(_tidyTemplate);
+        }
+
+        _tidyTemplate = tidyCreate();
+
+        [options applyToTidyDoc:_tidyTemplate];
+
+        _tidyTemplateOptions = options;
     }
-    else
+
+    return _tidyTemplate;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyOptionDidChange: (private)
+ *    Called by our JSDTidyOption instances when their values
+ *    change, so that the template is rebuilt before the next run.
+ *    Within an option update, the notification waits for the
+ *    commit.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)tidyOptionDidChange:(JSDTidyOption *)tidyOption
+{
+    _optionSet = nil;
+
+    if (_optionUpdateDepth == 0)
     {
-        tidyResult = @"";
+        [self notifyTidyModelOptionChanged:tidyOption values:@{tidyOption.name : tidyOption.optionValue}];
     }
+}
 
-    /* Clean up. */
 
-    tidyBufFree(outBuffer);
-    free(outBuffer);
-    tidyBufFree(errBuffer);
-    free(errBuffer);
-    tidyRelease(newTidy);
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyRunPublish: (private)
+ *    Copies the results of a completed run into our properties
+ *    and sends the notifications for whatever changed.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)tidyRunPublish:(JSDTidyRun *)run
+{
+    atomic_store(&_publishedGeneration, run.generation);
 
+    /* Set ivars for properties. */
 
-    BOOL textDidChange = ![self.tidyText isEqualToString:tidyResult];
+    _tidyDetectedHtmlVersion = run.tidyDetectedHtmlVersion;
+    _tidyDetectedXhtml       = run.tidyDetectedXhtml;
+    _tidyDetectedGenericXml  = run.tidyDetectedGenericXml;
+    _tidyStatus              = run.tidyStatus;
+    _tidyErrorCount          = run.tidyErrorCount;
+    _tidyWarningCount        = run.tidyWarningCount;
+    _tidyAccessWarningCount  = run.tidyAccessWarningCount;
+    _tidyAllocationCount     = run.allocationCount;
+    _tidyAllocationPeakBytes = run.allocationPeakBytes;
+    _tidyResultWasCached     = run.resultWasCached;
+    _tidyResultWasReprinted  = run.resultWasReprinted;
+    _tidyStoppedEarly        = run.stoppedEarly;
+    _tidyBudgetStatus        = run.budgetStatus;
+
+    self.errorText = run.errorText;
+
+
+    /* Compare bytes rather than strings; the string is only built
+     * if someone asks for it. Deferred output isn't known yet, so
+     * it's always a change, and it's printed when it's read.
+     */
+    BOOL textDidChange = run.outputDeferred || ![_tidyTextAsUTF8Data isEqualToData:run.tidyData];
 
     if (textDidChange)
     {
-        self.tidyText = tidyResult;
+        [self willChangeValueForKey:@"tidyText"];
+        _tidyTextAsUTF8Data = run.outputDeferred ? nil : run.tidyData;
+        _tidyText = nil;
+        _deferredRun = run.outputDeferred ? run : nil;
+        [self didChangeValueForKey:@"tidyText"];
     }
 
 
@@ -845,41 +1393,158 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
         [self notifyTidyModelTidyTextChanged];
     }
 
-    /* Send messages changed notification if applicable. */
-    if (![self.errorArray isEqualToArray:self.errorArrayB])
+    /* Send messages changed notification if applicable. Comparing the
+     * lists doesn't format any messages.
+     */
+    if (![run.errorArray isEqualToMessageList:self.errorArray])
     {
-        self.errorArray = self.errorArrayB;
+        self.errorArrayChanges = [run.errorArray changesFromMessages:self.errorArray];
+        self.errorArray = run.errorArray;
         [self notifyTidyModelMessagesChanged];
     }
 }
 
 
+#pragma mark - Fail-Fast Linting
+
+
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - errorFilterWithLocalization:Level:Line:Column:Code:Arguments:
- *    This is the REAL TidyError filter, and is called by the
- *    standard C `tidyCallBackFilter2` function implemented at the
- *    top of this file.
- *
- *    libtidy doesn't maintain a structured list of all of its
- *    errors so here we capture them one-by-one as Tidy tidy's.
- *    In this way we build our own structured list.
+ * + lintFilesAtURLs:withOptionSet:stopAfterReportCount:atReportLevel:resultHandler:
+ *    Models aren't safe off of the main thread, so this uses the
+ *    batch processor's runs and TidyDoc pools instead.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (bool)errorFilterWithLocalization:(TidyDoc)tDoc
-                              Level:(TidyReportLevel)lvl
-                               Line:(uint)line
-                             Column:(uint)col
-                            Message:(ctmbstr)code
-                          Arguments:(va_list)args
++ (void)lintFilesAtURLs:(NSArray<NSURL *> *)fileURLs
+          withOptionSet:(JSDTidyOptionSet *)optionSet
+   stopAfterReportCount:(NSUInteger)count
+          atReportLevel:(TidyReportLevel)level
+          resultHandler:(JSDTidyLintResultHandler)resultHandler
+{
+    JSDTidyBatchProcessor *processor = [[JSDTidyBatchProcessor alloc] initWithOptionSet:optionSet];
+
+    processor.runMode              = JSDTidyRunModeDiagnosticsOnly;
+    processor.stopAfterReportCount = count;
+    processor.stopAtReportLevel    = level;
+
+    [processor processFileURLs:fileURLs resultHandler:^(JSDTidyBatchResult *result) {
+
+        if (resultHandler)
+        {
+            resultHandler(result.fileURL, result);
+        }
+    }];
+}
+
+
+#pragma mark - Multiple Outputs
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyTextsForOutputProfiles:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSDictionary<NSString *, NSString *> *)tidyTextsForOutputProfiles:(NSArray<NSString *> *)profiles
+{
+    static NSDictionary<NSString *, NSDictionary *> *profileValues;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        profileValues = @{ JSDTidyOutputProfileDocument : @{ @"show-body-only" : @"0" },
+                           JSDTidyOutputProfileBodyOnly : @{ @"show-body-only" : @"1" },
+                           JSDTidyOutputProfileXHTML    : @{ @"show-body-only" : @"0", @"output-xhtml" : @"1" },
+                           JSDTidyOutputProfileXML      : @{ @"show-body-only" : @"0", @"output-xml" : @"1" } };
+    });
+
+    NSMutableDictionary<NSString *, NSDictionary *> *optionValues = [[NSMutableDictionary alloc] init];
+
+    for (NSString *profile in profiles)
+    {
+        if (profileValues[profile])
+        {
+            optionValues[profile] = profileValues[profile];
+        }
+    }
+
+    return [self tidyTextsForOptionValues:optionValues];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyTextsForOptionValues:
+ *    Variants are grouped by parse fingerprint, and each group
+ *    gets one run that parses once and prints once per variant.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSDictionary<NSString *, NSString *> *)tidyTextsForOptionValues:(NSDictionary<NSString *, NSDictionary *> *)optionValues
+{
+    JSDTidyOptionSet *baseOptions = self.optionSet;
+
+    NSMutableDictionary<NSNumber *, NSMutableDictionary<NSString *, JSDTidyOptionSet *> *> *groups = [[NSMutableDictionary alloc] init];
+
+    for (NSString *name in optionValues)
+    {
+        JSDTidyOptionSet *options = [baseOptions optionSetByMergingDictionary:optionValues[name]];
+        NSNumber *parseFingerprint = @(options.parseFingerprint);
+
+        if (!groups[parseFingerprint])
+        {
+            groups[parseFingerprint] = [[NSMutableDictionary alloc] init];
+        }
+
+        groups[parseFingerprint][name] = options;
+    }
+
+    NSMutableDictionary<NSString *, NSString *> *texts = [[NSMutableDictionary alloc] initWithCapacity:optionValues.count];
+
+    for (NSNumber *parseFingerprint in groups)
+    {
+        NSDictionary<NSString *, NSData *> *outputs = [self tidyDataForOptionSets:groups[parseFingerprint]
+                                                                       sourceText:[self.sourceText copy]
+                                                                       sourceData:self.sourceDataUTF8];
+
+        for (NSString *name in outputs)
+        {
+            NSString *text = [[NSString alloc] initWithData:outputs[name] encoding:NSUTF8StringEncoding];
+
+            texts[name] = text ? text : @"";
+        }
+    }
+
+    return texts;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - tidyDataForOptionSets:sourceText:sourceData: (private)
+ *    Prints the source once with each of `optionSets`, which must
+ *    all have the same parse fingerprint, using a run of its own.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSDictionary<NSString *, NSData *> *)tidyDataForOptionSets:(NSDictionary<NSString *, JSDTidyOptionSet *> *)optionSets
+                                                   sourceText:(NSString *)sourceText
+                                                   sourceData:(NSData *)sourceData
 {
-    JSDTidyMessage *message = [[JSDTidyMessage alloc] initWithLevel:lvl
-                                                               Line:line
-                                                             Column:col
-                                                            Message:code
-                                                          Arguments:args];
+    JSDTidyOptionSet *options = optionSets.allValues.firstObject;
+
+    if (!options)
+    {
+        return @{};
+    }
+
+    JSDTidyDocEntry *entry = [_tidyDocPool checkOut];
+
+    [options applyToTidyDoc:entry->tidyDoc];
+
+    JSDTidyRun *run = [[JSDTidyRun alloc] init];
 
-    [self.errorArrayB addObject:message];
+    run.sourceText = sourceText;
+    run.sourceData = sourceData;
+    run.entry      = entry;
+    run.pool       = _tidyDocPool;
+    run.cache      = self.resultCache;
+    run.options    = options;
 
-    return YES; // Always return yes otherwise self.errorText will be surpressed by libtidy.
+    run.timeBudget       = self.timeBudget;
+    run.allocationBudget = self.allocationBudget;
+    run.memoryBudget     = self.memoryBudget;
+
+    return [run executePrintingOptionSets:optionSets];
 }
 
 
@@ -1019,26 +1684,9 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 {
     [self willChangeValueForKey:@"tidyOptionsBindable"];
 
-    JSDTidyOption *localOption;
-
-    for (NSString *optionName in [[self class] optionsBuiltInOptionList])
-    {
-        NSString *valueFromPreferences = [[defaults objectForKey:JSDKeyTidyTidyOptionsKey] objectForKey:optionName];
-
-        localOption = self.tidyOptions[optionName];
-
-        if (localOption)
-        {
-            localOption.optionValue = valueFromPreferences;
-        }
-    }
-
-    [self notifyTidyModelOptionChanged:nil];
-    
-    [self processTidy];
+    self.optionSet = [JSDTidyOptionSet optionSetWithUserDefaults:defaults];
 
     [self didChangeValueForKey:@"tidyOptionsBindable"];
-
 }
 
 
@@ -1092,11 +1740,15 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - notifyTidyModelOptionChanged: (private)
+ * - notifyTidyModelOptionChanged:values: (private)
+ *    The userInfo has the names and new values of the options
+ *    that changed.
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (void)notifyTidyModelOptionChanged:(JSDTidyOption *)tidyOption
+- (void)notifyTidyModelOptionChanged:(JSDTidyOption *)tidyOption values:(NSDictionary *)values
 {
-    [[NSNotificationCenter defaultCenter] postNotificationName:tidyNotifyOptionChanged object:self];
+    [[NSNotificationCenter defaultCenter] postNotificationName:tidyNotifyOptionChanged
+                                                        object:self
+                                                      userInfo:values];
 
     id localDelegate = self.delegate;
 
@@ -1162,11 +1814,20 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 {
     [self willChangeValueForKey:@"errorArray"];
     [self didChangeValueForKey:@"errorArray"];
-    [[NSNotificationCenter defaultCenter] postNotificationName:tidyNotifyTidyErrorsChanged object:self];
+
+    NSDictionary *userData = self.errorArrayChanges ? @{tidyNotifyTidyErrorsChangesKey : self.errorArrayChanges} : nil;
+
+    [[NSNotificationCenter defaultCenter] postNotificationName:tidyNotifyTidyErrorsChanged
+                                                        object:self
+                                                      userInfo:userData];
 
     id localDelegate = self.delegate;
 
-    if ([localDelegate respondsToSelector:@selector(tidyModelTidyMessagesChanged:messages:)])
+    if ([localDelegate respondsToSelector:@selector(tidyModelTidyMessagesChanged:messages:changes:)])
+    {
+        [localDelegate tidyModelTidyMessagesChanged:self messages:self.errorArray changes:self.errorArrayChanges];
+    }
+    else if ([localDelegate respondsToSelector:@selector(tidyModelTidyMessagesChanged:messages:)])
     {
         [localDelegate tidyModelTidyMessagesChanged:self messages:self.errorArray];
     }
@@ -1196,4 +1857,959 @@ BOOL tidyReportCallback( TidyDoc tdoc, TidyReportLevel lvl, uint line, uint col,
 }
 
 
+@end
+
+
+#pragma mark - IMPLEMENTATION JSDTidyDocPool
+
+
+@implementation JSDTidyDocPool
+{
+    JSDTidyDocEntry *_idle[JSDTidyDocPoolCapacity];  // Entries ready for reuse.
+    NSUInteger _idleCount;                           // Number of entries in _idle.
+    JSDTidyParsedDoc *_parsedDoc;                    // The most recent parse, if kept.
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + initialize
+ *   Force the library to use its default localization! Otherwise
+ *   we will get Tidy's localized strings instead of our own. The
+ *   language is global to libtidy, so it's set once, before any
+ *   TidyDoc is handed out, rather than while other threads may be
+ *   formatting reports.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (void)initialize
+{
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        tidySetLanguage( "en" );
+    });
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - dealloc
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)dealloc
+{
+    while (_idleCount > 0)
+    {
+        [self freeEntry:_idle[--_idleCount]];
+    }
+
+    if (_parsedDoc)
+    {
+        [self freeEntry:_parsedDoc.entry];
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - checkOut
+ *    Returns an idle entry if there is one, or a brand new one.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyDocEntry *)checkOut
+{
+    JSDTidyDocEntry *entry = NULL;
+
+    @synchronized (self)
+    {
+        if (_idleCount > 0)
+        {
+            entry = _idle[--_idleCount];
+        }
+    }
+
+    if (!entry)
+    {
+        entry = malloc(sizeof(JSDTidyDocEntry));
+
+        JSDTidyArenaInit(&entry->arena, JSDTidyArenaDefaultLimit);
+        tidyBufInit(&entry->outBuffer);
+        tidyBufInit(&entry->errBuffer);
+    }
+
+    entry->tidyDoc = tidyCreateWithAllocator(&entry->arena.allocator);
+
+    return entry;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - checkIn:
+ *    Empties the buffers without releasing their memory, and
+ *    keeps the entry if there's room for it.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)checkIn:(JSDTidyDocEntry *)entry
+{
+    tidyRelease(entry->tidyDoc);
+
+    [self abandon:entry];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - abandon:
+ *    Checks in an entry without releasing its TidyDoc, which is
+ *    what's needed after a budget escaped from libtidy. The TidyDoc
+ *    lives entirely in the arena, so resetting the arena is enough
+ *    to dispose of it.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)abandon:(JSDTidyDocEntry *)entry
+{
+    entry->tidyDoc = NULL;
+
+    JSDTidyArenaReset(&entry->arena);
+
+    tidyBufClear(&entry->outBuffer);
+    tidyBufClear(&entry->errBuffer);
+
+    @synchronized (self)
+    {
+        if (_idleCount < JSDTidyDocPoolCapacity)
+        {
+            _idle[_idleCount++] = entry;
+            return;
+        }
+    }
+
+    [self freeEntry:entry];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - takeParsedDoc
+ *    The caller becomes responsible for the parsed doc's entry,
+ *    and must either keep it again or check it in.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyParsedDoc *)takeParsedDoc
+{
+    JSDTidyParsedDoc *parsedDoc;
+
+    @synchronized (self)
+    {
+        parsedDoc = _parsedDoc;
+        _parsedDoc = nil;
+    }
+
+    return parsedDoc;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - keepParsedDoc:
+ *    Only one parsed doc is kept; a previous one is checked in.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)keepParsedDoc:(JSDTidyParsedDoc *)parsedDoc
+{
+    JSDTidyParsedDoc *previous;
+
+    @synchronized (self)
+    {
+        previous = _parsedDoc;
+        _parsedDoc = parsedDoc;
+    }
+
+    if (previous)
+    {
+        [self checkIn:previous.entry];
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - freeEntry: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)freeEntry:(JSDTidyDocEntry *)entry
+{
+    if (entry->tidyDoc)
+    {
+        tidyRelease(entry->tidyDoc);
+    }
+
+    JSDTidyArenaDestroy(&entry->arena);
+    tidyBufFree(&entry->outBuffer);
+    tidyBufFree(&entry->errBuffer);
+    free(entry);
+}
+
+
+@end
+
+
+#pragma mark - IMPLEMENTATION JSDTidyParsedDoc
+
+
+@implementation JSDTidyParsedDoc
+
+@end
+
+
+#pragma mark - IMPLEMENTATION JSDTidyRun
+
+
+@implementation JSDTidyRun
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - init
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)init
+{
+    if (self = [super init])
+    {
+        _sourceText = @"";
+        _tidyData   = [[NSData alloc] init];
+        _errorText  = @"";
+        _errorArray = [[JSDTidyMessageList alloc] init];
+        _entry      = NULL;
+    }
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - dealloc
+ *    Runs that were skipped never return their TidyDoc.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)dealloc
+{
+    if (_entry)
+    {
+        [_pool checkIn:_entry];
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - execute
+ *    Parses the source text snapshot and captures all of the
+ *    results, unless they're cached, or the pool's parsed doc
+ *    only has to be printed again. This is safe to call from any
+ *    thread.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)execute
+{
+    JSDTidyDocEntry *entry = self.entry;
+
+    if (!entry)
+    {
+        self.tidyData = [[NSData alloc] init];
+        return;
+    }
+
+    JSDTidyByteSource byteSource = [self byteSource];
+
+
+    /* If this source has already been tidied with these options, then
+     * there's nothing for libtidy to do.
+     */
+
+    JSDTidyResultKey key = JSDTidyResultKeyMake(byteSource.bytes, byteSource.length, self.options.fingerprint);
+
+    JSDTidyCachedResult *cachedResult = [self.cache resultForKey:key];
+
+    if (cachedResult)
+    {
+        [self takeCachedResult:cachedResult];
+
+        if (self.runMode == JSDTidyRunModeDiagnosticsOnly)
+        {
+            self.tidyData  = [[NSData alloc] init];
+            self.errorText = @"";
+        }
+
+        [self.pool checkIn:entry];
+
+        self.entry = NULL;
+
+        return;
+    }
+
+
+    /* If the previous run repaired this same source with the same parse
+     * options, then only output options have changed, and its document
+     * only has to be printed again, if it has to be printed at all.
+     */
+
+    JSDTidyParsedDoc *parsedDoc = [self takeParsedDocForKey:key];
+
+    if (parsedDoc)
+    {
+        [self.pool checkIn:entry];
+
+        self.entry = NULL;
+
+        if (self.runMode == JSDTidyRunModeComplete)
+        {
+            [self reprintParsedDoc:parsedDoc];
+
+            [self.cache storeResult:[self resultWithKey:key]];
+        }
+        else
+        {
+            [self takeResultsOfParsedDoc:parsedDoc];
+
+            [self finishWithoutOutput];
+        }
+
+        [self.pool keepParsedDoc:parsedDoc];
+
+        return;
+    }
+
+    BOOL withinBudgets = [self parseByteSource:&byteSource];
+
+
+    /* Capture the allocator statistics before the arena is reset. */
+
+    self.allocationCount     = entry->arena.allocationCount;
+    self.allocationPeakBytes = entry->arena.peakBytes;
+
+
+    /* A document that exceeded a budget is abandoned where it stood. */
+
+    if (!withinBudgets)
+    {
+        self.tidyData = [[NSData alloc] init];
+
+        [self.pool abandon:entry];
+
+        self.entry = NULL;
+
+        return;
+    }
+
+
+    /* Diagnostics don't need the document any more, and its errorText
+     * is empty, so it's of no use for printing later. A document that
+     * was stopped early is incomplete, so it isn't printed, kept, or
+     * cached at all.
+     */
+
+    if (self.stoppedEarly)
+    {
+        self.tidyData = [[NSData alloc] init];
+
+        [self.pool checkIn:entry];
+
+        self.entry = NULL;
+
+        return;
+    }
+
+    if (self.runMode == JSDTidyRunModeDiagnosticsOnly)
+    {
+        [self finishWithoutOutput];
+
+        [self.pool checkIn:entry];
+
+        self.entry = NULL;
+
+        return;
+    }
+
+
+    /* Save the tidy'd text, and remember the results for the next time
+     * this source is tidied with these options. Deferred output is
+     * saved and remembered when it's printed.
+     */
+
+    JSDTidyCachedResult *result;
+
+    if (self.runMode == JSDTidyRunModeComplete)
+    {
+        tidySaveBuffer(entry->tidyDoc, &entry->outBuffer);
+
+        [self takeOutputBuffer:&entry->outBuffer];
+
+        result = [self resultWithKey:key];
+
+        [self.cache storeResult:result];
+    }
+    else
+    {
+        result = [self resultWithKey:key];
+
+        [self finishWithoutOutput];
+    }
+
+
+    /* Keep the repaired document instead of returning it to the pool,
+     * in case only output options change before the next run, or the
+     * deferred output is read.
+     */
+
+    JSDTidyParsedDoc *newParsedDoc = [[JSDTidyParsedDoc alloc] init];
+
+    newParsedDoc.entry            = entry;
+    newParsedDoc.parseFingerprint = self.options.parseFingerprint;
+    newParsedDoc.result           = result;
+
+    [self.pool keepParsedDoc:newParsedDoc];
+
+    self.entry = NULL;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - executePrintingOptionSets:
+ *    Parses and repairs the source once, with `options`, and then
+ *    prints it once with each of `optionSets`, which must all have
+ *    the same parse fingerprint as `options`. If the pool's parsed
+ *    doc is for the same source and parse options, it's printed
+ *    instead, and is kept for the model's next run. Texts that are
+ *    in the cache aren't printed at all, and the ones that are
+ *    printed are added to it.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSDictionary<NSString *, NSData *> *)executePrintingOptionSets:(NSDictionary<NSString *, JSDTidyOptionSet *> *)optionSets
+{
+    JSDTidyDocEntry *entry = self.entry;
+
+    if (!entry)
+    {
+        return @{};
+    }
+
+    JSDTidyByteSource byteSource = [self byteSource];
+
+    NSMutableDictionary<NSString *, NSData *> *texts = [[NSMutableDictionary alloc] initWithCapacity:optionSets.count];
+
+    NSMutableArray<NSString *> *namesToPrint = [[NSMutableArray alloc] initWithCapacity:optionSets.count];
+
+    for (NSString *name in optionSets)
+    {
+        JSDTidyResultKey key = JSDTidyResultKeyMake(byteSource.bytes, byteSource.length, optionSets[name].fingerprint);
+
+        JSDTidyCachedResult *cachedResult = [self.cache resultForKey:key];
+
+        if (cachedResult)
+        {
+            texts[name] = cachedResult.tidyData;
+        }
+        else
+        {
+            [namesToPrint addObject:name];
+        }
+    }
+
+    if (namesToPrint.count == 0)
+    {
+        [self.pool checkIn:entry];
+
+        self.entry = NULL;
+
+        return texts;
+    }
+
+    JSDTidyResultKey key = JSDTidyResultKeyMake(byteSource.bytes, byteSource.length, self.options.fingerprint);
+
+    JSDTidyParsedDoc *parsedDoc = [self takeParsedDocForKey:key];
+
+    BOOL isPoolsParsedDoc = (parsedDoc != nil);
+
+    if (isPoolsParsedDoc)
+    {
+        [self.pool checkIn:entry];
+
+        [self takeResultsOfParsedDoc:parsedDoc];
+    }
+    else
+    {
+        if (![self parseByteSource:&byteSource])
+        {
+            [self.pool abandon:entry];
+
+            self.entry = NULL;
+
+            return texts;
+        }
+
+        parsedDoc = [[JSDTidyParsedDoc alloc] init];
+        parsedDoc.entry = entry;
+    }
+
+    self.entry = NULL;
+
+    /* The messages were captured by the parse, so the error filter
+     * ignores anything that the printer might report.
+     */
+    self.ignoresReports = YES;
+
+    tidySetAppData(parsedDoc.entry->tidyDoc, (__bridge void *)(self));
+
+    for (NSString *name in namesToPrint)
+    {
+        JSDTidyOptionSet *options = optionSets[name];
+
+        [self printParsedDoc:parsedDoc withOptions:options];
+
+        texts[name] = self.tidyData;
+
+        [self.cache storeResult:[self resultWithKey:JSDTidyResultKeyMake(byteSource.bytes, byteSource.length, options.fingerprint)]];
+    }
+
+    if (isPoolsParsedDoc)
+    {
+        [self.pool keepParsedDoc:parsedDoc];
+    }
+    else
+    {
+        [self.pool checkIn:parsedDoc.entry];
+    }
+
+    return texts;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - byteSource (private)
+ *    The input source reads the UTF-8 bytes in place, whether they
+ *    belong to `sourceData` or to `sourceText`.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyByteSource)byteSource
+{
+    JSDTidyByteSource byteSource;
+
+    if (self.sourceData)
+    {
+        byteSource.bytes  = self.sourceData.bytes;
+        byteSource.length = self.sourceData.length;
+    }
+    else
+    {
+        const char *utf8 = [self.sourceText UTF8String];
+
+        byteSource.bytes  = (const uint8_t *)utf8;
+        byteSource.length = strlen(utf8);
+    }
+
+    byteSource.position = 0;
+    byteSource.stopped  = false;
+    byteSource.arena    = NULL;
+
+    return byteSource;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - takeParsedDocForKey: (private)
+ *    Returns the pool's parsed doc if it was repaired from the
+ *    same source with the same parse options as ours. A parsed doc
+ *    that doesn't match is of no further use.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyParsedDoc *)takeParsedDocForKey:(JSDTidyResultKey)key
+{
+    JSDTidyParsedDoc *parsedDoc = [self.pool takeParsedDoc];
+
+    if (!parsedDoc)
+    {
+        return nil;
+    }
+
+    JSDTidyResultKey parsedKey = parsedDoc.result.key;
+
+    if (parsedDoc.parseFingerprint == self.options.parseFingerprint &&
+        parsedKey.sourceHash == key.sourceHash &&
+        parsedKey.sourceLength == key.sourceLength &&
+        parsedKey.libraryHash == key.libraryHash)
+    {
+        return parsedDoc;
+    }
+
+    [self.pool checkIn:parsedDoc.entry];
+
+    return nil;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - parseByteSource: (private)
+ *    Parses, cleans, and repairs the source into our entry's
+ *    TidyDoc, and captures everything but the tidy text. Returns
+ *    NO if a budget was exceeded, in which case the TidyDoc must
+ *    be abandoned rather than checked in.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)parseByteSource:(JSDTidyByteSource *)byteSource
+{
+    JSDTidyDocEntry *entry = self.entry;
+
+    TidyDoc newTidy = entry->tidyDoc;
+
+
+    /* Setup for using and out-of-class C function as a callback
+     * from libtidy in order to collect cleanup and diagnostic
+     * information. The C function is defined near the top of
+     * this file.
+     */
+    tidySetAppData(newTidy, (__bridge void *)(self));
+
+    tidySetReportCallback(newTidy, (TidyReportCallback)&tidyReportCallback);
+
+
+    /* Setup the error buffer to catch errors here instead of stdout */
+
+    TidyBuffer *errBuffer = &entry->errBuffer;
+    tidySetErrorBuffer(newTidy, errBuffer);
+
+
+    /* Setup tidy to use UTF8 for all internal operations. */
+
+    tidyOptSetValue(newTidy, TidyCharEncoding, [@"utf8" UTF8String]);
+    tidyOptSetValue(newTidy, TidyInCharEncoding, [@"utf8" UTF8String]);
+    tidyOptSetValue(newTidy, TidyOutCharEncoding, [@"utf8" UTF8String]);
+
+
+    /* Likewise always produce LF; the model applies `newline` itself
+     * when the text is saved, and the editor only ever sees LF.
+     */
+
+    tidyOptSetInt(newTidy, TidyNewline, TidyLF);
+
+
+    /* Parse the source and clean, repair, and diagnose it. */
+
+    TidyInputSource inputSource;
+
+    tidyInitSource(&inputSource, byteSource, &JSDTidyByteSourceGetByte, &JSDTidyByteSourceUngetByte, &JSDTidyByteSourceIsEOF);
+
+    self.parsingSource = byteSource;
+
+    if (![self parseAndRepairWithinBudgets:&inputSource])
+    {
+        self.parsingSource = NULL;
+
+        /* The TidyDoc can't be asked for anything now, and the messages
+         * only go as far as the budget did.
+         */
+        self.tidyStatus = -1;
+        self.errorText  = @"";
+
+        return NO;
+    }
+
+    self.parsingSource = NULL;
+
+    /* Not needed, unless LibTidy formalizes its footnotes support. */
+//    tidyRunDiagnostics(newTidy);
+
+
+    /* While parsing, libtidy adjusts some of the options for the printer,
+     * and after printing it restores the options from the snapshot it took
+     * before parsing. Taking our own snapshot now keeps the adjustments,
+     * so that the document can be printed again later, just as now.
+     */
+    tidyOptSnapshot(newTidy);
+
+
+    /* Write additional information to the error output sink.
+     * Note that this information is NOT captured in the error filter,
+     * and that diagnostics don't use the error output at all.
+     */
+    if (self.runMode != JSDTidyRunModeDiagnosticsOnly)
+    {
+        tidyErrorSummary(newTidy);
+        tidyGeneralInfo(newTidy);
+    }
+
+
+    /* Capture the status. */
+
+    self.tidyDetectedHtmlVersion = tidyDetectedHtmlVersion(newTidy);
+    self.tidyDetectedXhtml       = tidyDetectedXhtml(newTidy);
+    self.tidyDetectedGenericXml  = tidyDetectedGenericXml(newTidy);
+    self.tidyStatus              = tidyStatus(newTidy);
+    self.tidyErrorCount          = tidyErrorCount(newTidy);
+    self.tidyWarningCount        = tidyWarningCount(newTidy);
+    self.tidyAccessWarningCount  = tidyAccessWarningCount(newTidy);
+
+
+    /* Copy the error buffer into an NSString. */
+
+    if (errBuffer->size > 0 && self.runMode != JSDTidyRunModeDiagnosticsOnly)
+    {
+        self.errorText = [[NSString alloc] initWithUTF8String:(char *)errBuffer->bp];
+    }
+    else
+    {
+        self.errorText = @"";
+    }
+
+    return YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - parseAndRepairWithinBudgets: (private)
+ *    When a budget is exceeded, the arena longjmps from deep
+ *    within libtidy back to here, and this returns NO. Nothing in
+ *    between is Objective-C that has to clean up after itself.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)parseAndRepairWithinBudgets:(TidyInputSource *)inputSource
+{
+    JSDTidyDocEntry *entry = self.entry;
+
+    uint64_t deadline = 0;
+
+    if (self.timeBudget > 0)
+    {
+        deadline = JSDTidyMonotonicTime() + (uint64_t)(self.timeBudget * NSEC_PER_SEC);
+    }
+
+    JSDTidyArenaSetBudgets(&entry->arena, self.memoryBudget, self.allocationBudget, deadline);
+
+    if (self.parsingSource)
+    {
+        self.parsingSource->arena = &entry->arena;
+    }
+
+    jmp_buf escape;
+
+    if (setjmp(escape) != 0)
+    {
+        switch (entry->arena.exceededBudget)
+        {
+            case JSDTidyArenaBudgetTime:
+                self.budgetStatus = JSDTidyBudgetStatusTimeExceeded;
+                break;
+
+            case JSDTidyArenaBudgetAllocations:
+                self.budgetStatus = JSDTidyBudgetStatusAllocationsExceeded;
+                break;
+
+            default:
+                self.budgetStatus = JSDTidyBudgetStatusMemoryExceeded;
+                break;
+        }
+
+        return NO;
+    }
+
+    JSDTidyArenaSetEscape(&entry->arena, &escape);
+
+    tidyParseSource(entry->tidyDoc, inputSource);
+
+    /* A document whose parsing was stopped is incomplete, so there's
+     * no point in repairing it.
+     */
+    if (!self.stoppedEarly)
+    {
+        tidyCleanAndRepair(entry->tidyDoc);
+    }
+
+    JSDTidyArenaSetEscape(&entry->arena, NULL);
+
+    return YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - printParsedDoc:withOptions: (private)
+ *    Prints an already repaired document into `tidyData` with the
+ *    output options of `options`.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)printParsedDoc:(JSDTidyParsedDoc *)parsedDoc withOptions:(JSDTidyOptionSet *)options
+{
+    JSDTidyDocEntry *entry = parsedDoc.entry;
+
+    [options applyOutputOptionsToTidyDoc:entry->tidyDoc];
+
+    tidyOptSnapshot(entry->tidyDoc);
+
+    tidySaveBuffer(entry->tidyDoc, &entry->outBuffer);
+
+    [self takeOutputBuffer:&entry->outBuffer];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - reprintParsedDoc: (private)
+ *    Prints the previous run's repaired document with our output
+ *    options.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)reprintParsedDoc:(JSDTidyParsedDoc *)parsedDoc
+{
+    /* The message list has already been published, so the error filter
+     * ignores anything that the printer might report.
+     */
+    self.ignoresReports = YES;
+    self.resultWasReprinted = YES;
+
+    tidySetAppData(parsedDoc.entry->tidyDoc, (__bridge void *)(self));
+
+    [self printParsedDoc:parsedDoc withOptions:self.options];
+
+    [self takeResultsOfParsedDoc:parsedDoc];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - takeResultsOfParsedDoc: (private)
+ *    Everything other than the text is the same as when the
+ *    parsed doc was parsed.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)takeResultsOfParsedDoc:(JSDTidyParsedDoc *)parsedDoc
+{
+    JSDTidyCachedResult *result = parsedDoc.result;
+
+    self.errorText               = result.errorText;
+    self.errorArray              = result.errorArray;
+    self.tidyDetectedHtmlVersion = result.tidyDetectedHtmlVersion;
+    self.tidyDetectedXhtml       = result.tidyDetectedXhtml;
+    self.tidyDetectedGenericXml  = result.tidyDetectedGenericXml;
+    self.tidyStatus              = result.tidyStatus;
+    self.tidyErrorCount          = result.tidyErrorCount;
+    self.tidyWarningCount        = result.tidyWarningCount;
+    self.tidyAccessWarningCount  = result.tidyAccessWarningCount;
+    self.allocationCount         = 0;
+    self.allocationPeakBytes     = 0;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - finishWithoutOutput (private)
+ *    Runs that don't print leave `tidyData` empty; in deferred mode
+ *    the model prints it later, when it's read.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)finishWithoutOutput
+{
+    self.tidyData = [[NSData alloc] init];
+
+    if (self.runMode == JSDTidyRunModeDeferredOutput)
+    {
+        self.outputDeferred = YES;
+    }
+    else
+    {
+        self.errorText = @"";
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - takeOutputBuffer: (private)
+ *    Copies the output out of the pooled buffer, which keeps its
+ *    capacity for the next run. One copy of the output is much
+ *    cheaper than growing a fresh buffer by repeated reallocs as
+ *    libtidy prints every document.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)takeOutputBuffer:(TidyBuffer *)outBuffer
+{
+    if (outBuffer->size > 0)
+    {
+        self.tidyData = [[NSData alloc] initWithBytes:outBuffer->bp length:outBuffer->size];
+    }
+    else
+    {
+        self.tidyData = [[NSData alloc] init];
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - resultWithKey: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyCachedResult *)resultWithKey:(JSDTidyResultKey)key
+{
+    JSDTidyCachedResult *result = [[JSDTidyCachedResult alloc] init];
+
+    result.key                     = key;
+    result.tidyData                = self.tidyData;
+    result.errorText               = self.errorText;
+    result.errorArray              = self.errorArray;
+    result.tidyDetectedHtmlVersion = self.tidyDetectedHtmlVersion;
+    result.tidyDetectedXhtml       = self.tidyDetectedXhtml;
+    result.tidyDetectedGenericXml  = self.tidyDetectedGenericXml;
+    result.tidyStatus              = self.tidyStatus;
+    result.tidyErrorCount          = self.tidyErrorCount;
+    result.tidyWarningCount        = self.tidyWarningCount;
+    result.tidyAccessWarningCount  = self.tidyAccessWarningCount;
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - takeCachedResult: (private)
+ *    The data and strings are immutable and are simply shared;
+ *    the messages get a list of their own, because messages are
+ *    created lazily by whichever model reads them.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)takeCachedResult:(JSDTidyCachedResult *)result
+{
+    self.tidyData                = result.tidyData;
+    self.errorText               = result.errorText;
+    self.errorArray              = [result.errorArray listSharingReports];
+    self.tidyDetectedHtmlVersion = result.tidyDetectedHtmlVersion;
+    self.tidyDetectedXhtml       = result.tidyDetectedXhtml;
+    self.tidyDetectedGenericXml  = result.tidyDetectedGenericXml;
+    self.tidyStatus              = result.tidyStatus;
+    self.tidyErrorCount          = result.tidyErrorCount;
+    self.tidyWarningCount        = result.tidyWarningCount;
+    self.tidyAccessWarningCount  = result.tidyAccessWarningCount;
+    self.allocationCount         = 0;
+    self.allocationPeakBytes     = 0;
+    self.resultWasCached         = YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - errorFilterWithLocalization:Level:Line:Column:Code:Arguments:
+ *    This is the REAL TidyError filter, and is called by the
+ *    standard C `tidyReportCallback` function implemented at the
+ *    top of this file.
+ *
+ *    libtidy doesn't maintain a structured list of all of its
+ *    errors so here we capture them one-by-one as Tidy tidy's.
+ *    In this way we build our own structured list.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (bool)errorFilterWithLocalization:(TidyDoc)tDoc
+                              Level:(TidyReportLevel)lvl
+                               Line:(uint)line
+                             Column:(uint)col
+                            Message:(ctmbstr)code
+                          Arguments:(va_list)args
+{
+    /* Reports made after parsing was stopped are about a document that
+     * has been cut short, so they aren't recorded either.
+     */
+    if (self.ignoresReports || self.stoppedEarly)
+    {
+        return NO;
+    }
+
+    /* Only record the report; JSDTidyMessageList creates and formats
+     * the messages themselves if and when they're used.
+     */
+    [self.errorArray addReportWithLevel:lvl line:line column:col code:code arguments:args];
+
+    /* Once enough reports at the stop level have been made, the input
+     * source reports the end of the file, and libtidy finishes parsing
+     * with whatever it has already read.
+     */
+    if (self.stopAfterReportCount > 0 && lvl == self.stopAtReportLevel)
+    {
+        self.stopReportCount++;
+
+        if (self.stopReportCount >= self.stopAfterReportCount)
+        {
+            self.stoppedEarly = YES;
+
+            if (self.parsingSource)
+            {
+                self.parsingSource->stopped = true;
+            }
+        }
+    }
+
+    /* Return yes, otherwise self.errorText will be surpressed by libtidy;
+     * diagnostics don't want it, so libtidy needn't format anything.
+     */
+    return (self.runMode != JSDTidyRunModeDiagnosticsOnly);
+}
+
+
 @end
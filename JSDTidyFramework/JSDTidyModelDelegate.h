@@ -9,6 +9,7 @@
 
 @class JSDTidyModel;
 @class JSDTidyOption;
+@class JSDTidyMessageChanges;
 
 /* JSDTidyFramework will post the following NSNotifications. */
 #define tidyNotifyOptionChanged                  @"JSDTidyDocumentOptionChanged"
@@ -18,6 +19,9 @@
 #define tidyNotifyTidyErrorsChanged              @"JSDTidyDocumentTidyErrorsChanged"
 #define tidyNotifyPossibleInputEncodingProblem   @"JSDTidyNotifyPossibleInputEncodingProblem"
 
+/* The userInfo key for the JSDTidyMessageChanges in tidyNotifyTidyErrorsChanged. */
+#define tidyNotifyTidyErrorsChangesKey           @"changes"
+
 
 #pragma mark - protocol JSDTidyModelDelegate
 
@@ -52,7 +56,9 @@
  *
  *  @param tidyModel Indicates the instance of the @c JSDTidyModel that is
  *    calling the delegate.
- *  @param tidyOption Indicates which instance of @c JSDTidyOption was changed.
+ *  @param tidyOption Indicates which instance of @c JSDTidyOption was changed,
+ *    or @c nil if several options were changed together by
+ *    @c commitOptionUpdates.
  */
 - (void)tidyModelOptionChanged:(JSDTidyModel *)tidyModel 
                         option:(JSDTidyOption *)tidyOption;
@@ -108,6 +114,25 @@
 - (void)tidyModelTidyMessagesChanged:(JSDTidyModel *)tidyModel
                             messages:(NSArray *)messages;
 
+/**
+ *  @c tidyModelTidyMessagesChanged:messages:changes: is the same as
+ *  @c tidyModelTidyMessagesChanged:messages:, but also describes which
+ *  messages were inserted and removed, so that the delegate can apply
+ *  small updates. If the delegate implements this method, then it will be
+ *  called instead of @c tidyModelTidyMessagesChanged:messages:. (The
+ *  corresponding @c NSNotification is defined by
+ *  @c tidyNotifyTidyErrorsChanged, and the changes are in its @c userInfo
+ *  under @c tidyNotifyTidyErrorsChangesKey.)
+ *
+ *  @param tidyModel Indicates the instance of the @c JSDTidyModel that is
+ *    calling the delegate.
+ *  @param messages Provides the array of error messages.
+ *  @param changes Describes the differences from the previous messages.
+ */
+- (void)tidyModelTidyMessagesChanged:(JSDTidyModel *)tidyModel
+                            messages:(NSArray *)messages
+                             changes:(JSDTidyMessageChanges *)changes;
+
 /**
  *  @c tidyModelDetectedInputEncodingIssue will be called when an
  *  @b input-encoding problem is detected when attempting to use
@@ -5,7 +5,7 @@
 //  Copyright © 2003-2019 by Jim Derry. All rights reserved.
 //
 
-@import Cocoa;
+@import Foundation;
 
 @import HTMLTidy;
 
@@ -227,6 +227,14 @@
  */
 @property (nonatomic, assign, readonly) BOOL optionIsEncodingOption;
 
+/**
+ *  Indicates whether or not this option only affects how @b libtidy prints
+ *  the repaired document, and not how the document is parsed, cleaned, and
+ *  repaired. When only these options change, @c JSDTidyModel prints its
+ *  already repaired document again instead of tidying the source again.
+ */
+@property (nonatomic, assign, readonly) BOOL optionIsOutputOnly;
+
 /**
  *  Fake option is only a header row for UI use.
  *
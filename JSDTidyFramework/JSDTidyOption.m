@@ -14,13 +14,171 @@
 #import "NSString+RTF.h"
 
 
+#pragma mark - CATEGORY JSDTidyModel (JSDTidyOption)
+
+
+/* Private JSDTidyModel methods that options use to keep their
+ * model informed.
+ */
+@interface JSDTidyModel (JSDTidyOption)
+
+- (void)tidyOptionDidChange:(JSDTidyOption *)tidyOption;
+
+@end
+
+
+#pragma mark - CLASS JSDTidyOptionMetadata (private)
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyOptionMetadata
+ *   Everything that libtidy knows about an option that can't
+ *   change at runtime. A single, immutable table of these is built
+ *   once per process, indexed by TidyOptionId, so that options
+ *   never have to create a TidyDoc simply to ask a question.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+
+@interface JSDTidyOptionMetadata : NSObject
+
+@property (nonatomic, assign, readonly) TidyOptionType type;
+
+@property (nonatomic, assign, readonly) TidyConfigCategory category;
+
+@property (nonatomic, assign, readonly) BOOL isReadOnly;
+
+@property (nonatomic, strong, readonly) NSString *defaultValue;
+
+@property (nonatomic, strong, readonly) NSArray *pickList;
+
+@property (nonatomic, strong, readonly) NSString *builtInDescription;
+
++ (JSDTidyOptionMetadata *)metadataForOptionId:(TidyOptionId)optionId;
+
+@end
+
+
+@implementation JSDTidyOptionMetadata
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + metadataForOptionId:
+ *    Returns nil for TidyUnknownOption and any other id that
+ *    libtidy doesn't know about.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (JSDTidyOptionMetadata *)metadataForOptionId:(TidyOptionId)optionId
+{
+    static NSArray *metadataTable = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+
+        NSMutableArray *table = [[NSMutableArray alloc] initWithCapacity:N_TIDY_OPTIONS];
+
+        TidyDoc dummyDoc = tidyCreate();
+
+        for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+        {
+            TidyOption tidyOptionInstance = tidyGetOption( dummyDoc, (TidyOptionId)i );
+
+            if (tidyOptionInstance)
+            {
+                [table addObject:[[JSDTidyOptionMetadata alloc] initWithTidyDoc:dummyDoc option:tidyOptionInstance]];
+            }
+            else
+            {
+                [table addObject:[NSNull null]];
+            }
+        }
+
+        tidyRelease(dummyDoc);
+
+        metadataTable = [table copy];
+    });
+
+    if (optionId <= TidyUnknownOption || optionId >= metadataTable.count)
+    {
+        return nil;
+    }
+
+    id result = metadataTable[optionId];
+
+    return (result == [NSNull null]) ? nil : result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithTidyDoc:option:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithTidyDoc:(TidyDoc)tidyDoc option:(TidyOption)tidyOptionInstance
+{
+    if (self = [super init])
+    {
+        _type       = tidyOptGetType(tidyOptionInstance);
+        _category   = tidyOptGetCategory(tidyOptionInstance);
+        _isReadOnly = tidyOptIsReadOnly(tidyOptionInstance);
+
+
+        /* Default value, as a string regardless of type. */
+
+        if (_type == TidyString)
+        {
+            ctmbstr tmp = tidyOptGetDefault(tidyOptionInstance);
+            _defaultValue = ( (tmp != nil) ? @(tmp) : @"" );
+        }
+        else if (_type == TidyBoolean)
+        {
+            _defaultValue = [NSString stringWithFormat:@"%u", tidyOptGetDefaultBool(tidyOptionInstance)];
+        }
+        else if (_type == TidyInteger)
+        {
+            _defaultValue = [NSString stringWithFormat:@"%lu", tidyOptGetDefaultInt(tidyOptionInstance)];
+        }
+        else
+        {
+            _defaultValue = @"";
+        }
+
+
+        /* Pick list. */
+
+        NSMutableArray *theArray = [[NSMutableArray alloc] init];
+
+        TidyIterator i = tidyOptGetPickList( tidyOptionInstance );
+
+        while ( i )
+        {
+            [theArray addObject:@(tidyOptGetNextPick(tidyOptionInstance, &i))];
+        }
+
+        /* Special treatment for `doctype` */
+        if ((tidyOptGetId(tidyOptionInstance) == TidyDoctype) && ([theArray count] > 0))
+        {
+            [theArray removeLastObject];
+        }
+
+        _pickList = [theArray copy];
+
+
+        /* Description. */
+
+        const char *tidyResultCString = tidyOptGetDoc(tidyDoc, tidyOptionInstance);
+
+        _builtInDescription = tidyResultCString ? @(tidyResultCString) : @"No description provided by libtidy.";
+    }
+
+    return self;
+}
+
+
+@end
+
+
 #pragma mark - IMPLEMENTATION
 
 
 @implementation JSDTidyOption
 {
-    BOOL _builtInTouched;  // Flag to indicate property has been read once.
-
+    JSDTidyOptionMetadata *_metadata;  // Shared, immutable libtidy option data.
 }
 
 #pragma mark - iVar Synthesis
@@ -32,7 +190,6 @@
 @synthesize localizedHumanReadableName = _localizedHumanReadableName;
 @synthesize localizedHumanReadableDescription = _localizedHumanReadableDescription;
 @synthesize localizedHumanReadableCategory = _localizedHumanReadableCategory;
-@synthesize builtInCategory = _builtInCategory;
 
 #pragma mark - Initialization and Deallocation
 
@@ -69,9 +226,10 @@
         _name               = name;
         _optionIsHeader     = NO;
         _optionIsSuppressed = NO;
-        _builtInTouched     = NO;
+        _optionId           = [[self class] optionIdForName:name];
+        _metadata           = [JSDTidyOptionMetadata metadataForOptionId:_optionId];
 
-        if (self.optionId == TidyUnknownOption)
+        if (_optionId == TidyUnknownOption)
         {
             _name = @"undefined";
         }
@@ -132,16 +290,9 @@
             _optionValue = optionValue;
         }
 
-        [[NSNotificationCenter defaultCenter] postNotificationName:tidyNotifyOptionChanged
-                                                            object:self.sharedTidyModel
-                                                          userInfo:@{self.name : self.optionValue}];
-
-        id localDelegate = self.sharedTidyModel.delegate;
+        /* The model posts the notification, unless it's batching them. */
 
-        if ([localDelegate respondsToSelector:@selector(tidyModelOptionChanged:option:)])
-        {
-            [localDelegate tidyModelOptionChanged:self.sharedTidyModel option:self];
-        }
+        [self.sharedTidyModel tidyOptionDidChange:self];
     }
 }
 
@@ -169,31 +320,12 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (NSArray*)possibleOptionValues
 {
-    NSMutableArray *theArray = [[NSMutableArray alloc] init];
-    
     if (self.optionIsEncodingOption)
     {
         return [JSDStringEncodingTools encodingNames];
     }
-    else
-    {
-        TidyOption tidyOptionInstance = [self createTidyOptionInstance:self.optionId];
-        
-        TidyIterator i = tidyOptGetPickList( tidyOptionInstance );
-
-        while ( i )
-        {
-            [theArray addObject:@(tidyOptGetNextPick(tidyOptionInstance, &i))];
-        }
-        
-        /* Special treatment for `doctype` */
-        if (([_name isEqual: @"doctype"]) && ([theArray count] > 0))
-        {
-            [theArray removeLastObject];
-        }
-    }
     
-    return theArray;
+    return _metadata ? _metadata.pickList : @[];
 }
 
 
@@ -202,7 +334,7 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (BOOL)optionIsReadOnly
 {
-    return tidyOptIsReadOnly([self createTidyOptionInstance:self.optionId]);
+    return _metadata.isReadOnly;
 }
 
 
@@ -373,11 +505,11 @@
 
 
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * @optionId
+ * + optionIdForName: (private)
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (TidyOptionId)optionId
++ (TidyOptionId)optionIdForName:(NSString *)name
 {
-    TidyOptionId optID = tidyOptGetIdForName([_name UTF8String]);
+    TidyOptionId optID = tidyOptGetIdForName([name UTF8String]);
     
     if (optID < N_TIDY_OPTIONS)
     {
@@ -393,7 +525,7 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (TidyOptionType)optionType
 {
-    return tidyOptGetType([self createTidyOptionInstance:self.optionId]);
+    return _metadata.type;
 }
 
 
@@ -423,34 +555,12 @@
 
 
     /* doctype -- normally is nil, but we're going to force one. */
-    if ([self.name isEqualToString:@"doctype"])
+    if (_optionId == TidyDoctype)
     {
         return @"auto";
     }
 
-
-    TidyOption tidyOptionInstance = [self createTidyOptionInstance:self.optionId];
-
-    TidyOptionType optType = tidyOptGetType(tidyOptionInstance);
-
-
-    if (optType == TidyString)
-    {
-        ctmbstr tmp = tidyOptGetDefault(tidyOptionInstance);
-        return ( (tmp != nil) ? @(tmp) : @"" );
-    }
-    
-    if (optType == TidyBoolean)
-    {
-        return [NSString stringWithFormat:@"%u", tidyOptGetDefaultBool(tidyOptionInstance)];
-    }
-    
-    if (optType == TidyInteger)
-    {
-        return [NSString stringWithFormat:@"%lu", tidyOptGetDefaultInt(tidyOptionInstance)];
-    }
-    
-    return @"";
+    return _metadata ? _metadata.defaultValue : @"";
 }
 
 
@@ -459,25 +569,7 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (NSString*)builtInDescription
 {
-    NSString *tidyResultString;
-
-    TidyDoc dummyDoc = tidyCreate();
-    
-    const char *tidyResultCString = tidyOptGetDoc(dummyDoc, tidyGetOption(dummyDoc, self.optionId));
-    
-    
-    if (!tidyResultCString)
-    {
-        tidyResultString = @"No description provided by libtidy.";
-    }
-    else
-    {
-        tidyResultString = @(tidyResultCString);
-    }
-    
-    tidyRelease(dummyDoc);
-    
-    return tidyResultString;
+    return _metadata ? _metadata.builtInDescription : @"No description provided by libtidy.";
 }
 
 
@@ -486,13 +578,7 @@
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
 - (TidyConfigCategory)builtInCategory
 {
-    if ( !_builtInTouched)
-    {
-        _builtInCategory = tidyOptGetCategory( [self createTidyOptionInstance:self.optionId] );
-        _builtInTouched = YES;
-    }
-    
-    return _builtInCategory;
+    return _metadata.category;
 }
 
 
@@ -510,6 +596,24 @@
 }
 
 
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @optionIsOutputOnly
+ *   These are only read when printing; `show-body-only` simply
+ *   chooses which part of the tree is printed. `newline` doesn't
+ *   even reach libtidy; we always tidy to LF, and the model applies
+ *   it when saving.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)optionIsOutputOnly
+{
+    return ((self.optionId == TidyWrapLen) ||
+            (self.optionId == TidyIndentContent) ||
+            (self.optionId == TidyIndentSpaces) ||
+            (self.optionId == TidyVertSpace) ||
+            (self.optionId == TidyBodyOnly) ||
+            (self.optionId == TidyNewline));
+}
+
+
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * @optionIsList
  *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
@@ -761,24 +865,6 @@
 }
 
 
-/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
- * - createTidyOptionInstance: (private)
- *    Given an option id, return an instance of a tidy option.
- *    This is required because many of the libtidy functions
- *    require an instance in order to return data.
- *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
-- (TidyOption)createTidyOptionInstance:(TidyOptionId)idf
-{
-    TidyDoc dummyDoc  = tidyCreate();
-    
-    TidyOption result = tidyGetOption( dummyDoc, idf);
-    
-    tidyRelease(dummyDoc);
-    
-    return result;
-}
-
-
 /*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
  * - tidyGroupedCompareCommon:useLocalizedName: (private)
  *    Common sorting for tidyGroupedNameCompare and
@@ -0,0 +1,204 @@
+//
+//  JSDTidyOptionSet.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+@import HTMLTidy;
+
+
+/**
+ *  @c JSDTidyOptionSet is an immutable value holding a complete set of
+ *  @b libtidy option values, stored compactly by @c TidyOptionId: a bitset
+ *  for Boolean options, an integer for each integer and enumerated option,
+ *  and interned strings for string options.
+ *
+ *  Because option sets are immutable and their strings are interned,
+ *  copying one is free, comparing two is a comparison of their
+ *  @c fingerprint and then of their storage, and the values never have to
+ *  be parsed again in order to configure a TidyDoc.
+ *
+ *  Option values are represented as strings in the same format used by
+ *  @c [JSDTidyOption @c optionValue]: Booleans as @b 0 or @b 1, integers
+ *  and enumerations in decimal, encodings as @c NSStringEncoding values,
+ *  and strings as themselves.
+ */
+@interface JSDTidyOptionSet : NSObject <NSCopying>
+
+
+#pragma mark - Creating Option Sets
+
+
+/**
+ *  Returns an option set with @b libtidy's built-in defaults, as given by
+ *  @c [JSDTidyOption @c builtInDefaultValue].
+ */
++ (instancetype)optionSetWithBuiltInDefaults;
+
+/**
+ *  Returns an option set with values from a dictionary. Each key must be
+ *  an @c NSString with the name of a tidy option, e.g., @b input-encoding;
+ *  options that aren't in the dictionary have their built-in defaults.
+ *
+ *  @param dictionary Contains the key-value pairs representing the tidy
+ *    options to set.
+ */
++ (instancetype)optionSetWithDictionary:(NSDictionary *)dictionary;
+
+/**
+ *  Returns an option set with the values that were saved in
+ *  @c defaults by @c writeToUserDefaults: or
+ *  @c [JSDTidyModel @c writeOptionValuesWithDefaults:].
+ *
+ *  @param defaults The user defaults to read.
+ */
++ (instancetype)optionSetWithUserDefaults:(NSUserDefaults *)defaults;
+
+/**
+ *  Returns an option set with the values configured in a TidyDoc. The
+ *  encoding options aren't taken from the TidyDoc, because we always
+ *  give @b libtidy UTF-8; they have their built-in defaults.
+ *
+ *  @param tidyDoc The TidyDoc from which to read the values.
+ */
++ (instancetype)optionSetWithTidyDoc:(TidyDoc)tidyDoc;
+
+/**
+ *  Returns an option set with the values configured in a TidyDoc,
+ *  optionally including the encoding options. Encodings are converted
+ *  from @b libtidy's names to @c NSStringEncoding; those without an
+ *  equivalent, such as @b raw, have their built-in defaults.
+ *
+ *  @param tidyDoc The TidyDoc from which to read the values.
+ *  @param includeEncodings Whether to take the encoding options from
+ *    the TidyDoc, too.
+ */
++ (instancetype)optionSetWithTidyDoc:(TidyDoc)tidyDoc includingEncodings:(BOOL)includeEncodings;
+
+/**
+ *  Returns an option set with the values in a Tidy configuration file.
+ *  As with HTML Tidy, options that are not in the file have their
+ *  default values.
+ *
+ *  @param fileURL The @c NSURL of the file to load.
+ *  @returns Returns the option set, or @c nil if the file couldn't be
+ *    loaded.
+ */
++ (instancetype)optionSetWithConfigFile:(NSURL *)fileURL;
+
+/**
+ *  Returns an option set with the values in a Tidy configuration file,
+ *  optionally including its @b char-encoding, @b input-encoding, and
+ *  @b output-encoding; see @c optionSetWithTidyDoc:includingEncodings:.
+ *  The application ignores encodings in configuration files, but a
+ *  command line tool has no other way to be given them.
+ *
+ *  @param fileURL The @c NSURL of the file to load.
+ *  @param includeEncodings Whether to keep the encoding options.
+ *  @returns Returns the option set, or @c nil if the file couldn't be
+ *    loaded.
+ */
++ (instancetype)optionSetWithConfigFile:(NSURL *)fileURL includingEncodings:(BOOL)includeEncodings;
+
+/**
+ *  Returns an option set that is the same as the receiver, but with the
+ *  values from @c dictionary, which has the same form as for
+ *  @c optionSetWithDictionary:.
+ *
+ *  @param dictionary Contains the key-value pairs representing the tidy
+ *    options to change.
+ */
+- (instancetype)optionSetByMergingDictionary:(NSDictionary *)dictionary;
+
+
+#pragma mark - Option Values
+
+
+/**
+ *  Returns the value of an option.
+ *
+ *  @param name The name of the option, e.g., @b wrap.
+ *  @returns The value of the option, or @c nil if there isn't an option
+ *    with that name.
+ */
+- (NSString *)valueForOptionName:(NSString *)name;
+
+/**
+ *  Returns the names of the options whose values are different in
+ *  @c optionSet. This doesn't build any strings for the values.
+ *
+ *  @param optionSet The option set to compare with.
+ */
+- (NSArray<NSString *> *)optionNamesDifferingFromOptionSet:(JSDTidyOptionSet *)optionSet;
+
+/**
+ *  A 64 bit hash of all of the option values. It depends only upon the
+ *  values and @b libtidy's options, so it's the same from one run of the
+ *  application to the next, and can be used as part of a persistent key.
+ */
+@property (nonatomic, assign, readonly) uint64_t fingerprint;
+
+/**
+ *  A 64 bit hash like @c fingerprint, but of only the options that affect
+ *  how a document is parsed, cleaned, and repaired. Two option sets with
+ *  the same @c parseFingerprint differ only in options for which
+ *  @c [JSDTidyOption @c optionIsOutputOnly] is true.
+ */
+@property (nonatomic, assign, readonly) uint64_t parseFingerprint;
+
+/**
+ *  Indicates whether the receiver and @c optionSet have the same values.
+ *
+ *  @param optionSet The option set to compare with.
+ */
+- (BOOL)isEqualToOptionSet:(JSDTidyOptionSet *)optionSet;
+
+
+#pragma mark - Conversions
+
+
+/**
+ *  A dictionary of all of the option values, keyed by option name, in the
+ *  form used by @c optionSetWithDictionary:.
+ */
+@property (nonatomic, strong, readonly) NSDictionary<NSString *, NSString *> *dictionaryRepresentation;
+
+/**
+ *  Writes the option values into @c defaults, in the same place as
+ *  @c [JSDTidyModel @c writeOptionValuesWithDefaults:].
+ *
+ *  @param defaults The user defaults to write.
+ */
+- (void)writeToUserDefaults:(NSUserDefaults *)defaults;
+
+/**
+ *  The option values in the format of a Tidy configuration file, with one
+ *  line per option, sorted by option name. Enumerated values use their
+ *  @b libtidy names, and the encoding options are always @b utf8.
+ */
+@property (nonatomic, strong, readonly) NSString *configFileRepresentation;
+
+/**
+ *  Configures a TidyDoc with the option values. As with
+ *  @c [JSDTidyOption @c applyOptionToTidyDoc:], read-only options are
+ *  skipped and the encoding options are set to UTF-8.
+ *
+ *  @param tidyDoc The TidyDoc to configure.
+ */
+- (void)applyToTidyDoc:(TidyDoc)tidyDoc;
+
+/**
+ *  Configures a TidyDoc that has already been parsed, cleaned, and
+ *  repaired with the output-only option values, so that it can be
+ *  printed again with them. This makes the same adjustments to the values
+ *  that @b libtidy would have made while parsing.
+ *
+ *  @param tidyDoc The TidyDoc to configure.
+ */
+- (void)applyOutputOptionsToTidyDoc:(TidyDoc)tidyDoc;
+
+
+@end
@@ -0,0 +1,828 @@
+//
+//  JSDTidyOptionSet.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyOptionSet.h"
+#import "JSDTidyOption.h"
+#import "JSDTidyCommonHeaders.h"
+#import "JSDTidyFNVHash.h"
+#import "JSDTidyPlatform.h"
+
+
+#pragma mark - Option Storage
+
+
+#define JSDOptionSetWords ((N_TIDY_OPTIONS + 63) / 64)
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyOptionValues
+ *   The values of every option, indexed by TidyOptionId. Only the
+ *   array for an option's type is used; the others stay zero, so
+ *   that two sets of values can be compared with memcmp(). The
+ *   strings are interned and are never released, so they don't
+ *   need to be retained here.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDTidyOptionValues {
+    uint64_t booleans[JSDOptionSetWords];
+    unsigned long integers[N_TIDY_OPTIONS];
+    __unsafe_unretained NSString *strings[N_TIDY_OPTIONS];
+} JSDTidyOptionValues;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyOptionSlot
+ *   What we need to know about each TidyOptionId in order to
+ *   store, convert, and apply its value.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDTidyOptionSlot {
+    BOOL known;                    // libtidy has a public option with this id.
+    BOOL readOnly;
+    BOOL encoding;                 // One of the encoding options.
+    BOOL outputOnly;               // Only affects the pretty printer.
+    TidyOptionType type;
+    __unsafe_unretained NSString *name;
+    __unsafe_unretained NSArray *pickList;
+} JSDTidyOptionSlot;
+
+
+static JSDTidyOptionSlot JSDOptionSlots[N_TIDY_OPTIONS];
+
+static JSDTidyOptionValues JSDOptionDefaults;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetIntern
+ *   Returns the single, permanent instance of a string's value.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSString *JSDOptionSetIntern( NSString *string )
+{
+    static NSMutableSet *internTable = nil;
+    static JSDTidyLock internLock = JSDTidyLockInit;
+
+    JSDTidyLockLock(&internLock);
+
+    if (!internTable)
+    {
+        internTable = [[NSMutableSet alloc] init];
+    }
+
+    NSString *result = [internTable member:string];
+
+    if (!result)
+    {
+        result = [string copy];
+        [internTable addObject:result];
+    }
+
+    JSDTidyLockUnlock(&internLock);
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetStore
+ *   Parses an option value in JSDTidyOption's string format into
+ *   `values`. Values that aren't strings, such as NSNumbers from
+ *   a property list, are converted to strings first.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void JSDOptionSetStore( JSDTidyOptionValues *values, NSUInteger optionId, id value )
+{
+    NSString *string = [value isKindOfClass:[NSString class]] ? value : [value description];
+
+    switch (JSDOptionSlots[optionId].type)
+    {
+        case TidyBoolean:
+            if ([string boolValue])
+            {
+                values->booleans[optionId / 64] |= (1ULL << (optionId % 64));
+            }
+            else
+            {
+                values->booleans[optionId / 64] &= ~(1ULL << (optionId % 64));
+            }
+            break;
+
+        case TidyInteger:
+            values->integers[optionId] = (unsigned long)[string longLongValue];
+            break;
+
+        case TidyString:
+            values->strings[optionId] = JSDOptionSetIntern(string ?: @"");
+            break;
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetBool
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline BOOL JSDOptionSetBool( const JSDTidyOptionValues *values, NSUInteger optionId )
+{
+    return (values->booleans[optionId / 64] >> (optionId % 64)) & 1;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetString
+ *   The value of an option in JSDTidyOption's string format.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSString *JSDOptionSetString( const JSDTidyOptionValues *values, NSUInteger optionId )
+{
+    switch (JSDOptionSlots[optionId].type)
+    {
+        case TidyBoolean:
+            return JSDOptionSetBool(values, optionId) ? @"1" : @"0";
+
+        case TidyInteger:
+            return [NSString stringWithFormat:@"%lu", values->integers[optionId]];
+
+        case TidyString:
+            return values->strings[optionId] ?: @"";
+    }
+
+    return @"";
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetSameValue
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline BOOL JSDOptionSetSameValue( const JSDTidyOptionValues *a, const JSDTidyOptionValues *b, NSUInteger optionId )
+{
+    switch (JSDOptionSlots[optionId].type)
+    {
+        case TidyBoolean:
+            return JSDOptionSetBool(a, optionId) == JSDOptionSetBool(b, optionId);
+
+        case TidyInteger:
+            return a->integers[optionId] == b->integers[optionId];
+
+        case TidyString:
+            return a->strings[optionId] == b->strings[optionId];
+    }
+
+    return YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetLoadSlots
+ *   Builds the slot table and the built-in defaults once. The
+ *   defaults come from JSDTidyOption, which knows about the few
+ *   options whose defaults we change.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void JSDOptionSetLoadSlots( void )
+{
+    static NSArray *retainedObjects = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+
+        NSMutableArray *objects = [[NSMutableArray alloc] init];
+
+        TidyDoc dummyDoc = tidyCreate();
+
+        for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+        {
+            TidyOption tidyOptionInstance = tidyGetOption( dummyDoc, (TidyOptionId)i );
+
+            if ( !tidyOptionInstance || tidyOptGetCategory(tidyOptionInstance) >= TidyInternalCategory )
+            {
+                continue;
+            }
+
+            JSDTidyOption *option = [[JSDTidyOption alloc] initWithName:@(tidyOptGetName(tidyOptionInstance))
+                                                            optionValue:nil
+                                                           sharingModel:nil];
+            NSArray *pickList = option.possibleOptionValues ?: @[];
+
+            [objects addObject:option];
+            [objects addObject:pickList];
+
+            JSDTidyOptionSlot *slot = &JSDOptionSlots[i];
+
+            slot->known      = YES;
+            slot->readOnly   = option.optionIsReadOnly;
+            slot->encoding   = option.optionIsEncodingOption;
+            slot->outputOnly = option.optionIsOutputOnly;
+            slot->type       = option.optionType;
+            slot->name       = option.name;
+            slot->pickList   = pickList;
+
+            JSDOptionSetStore(&JSDOptionDefaults, i, option.builtInDefaultValue);
+        }
+
+        tidyRelease(dummyDoc);
+
+        /* The slots refer to the options' names and the pick lists. */
+        retainedObjects = [objects copy];
+    });
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetIdForName
+ *   Returns N_TIDY_OPTIONS for names that we don't store.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSUInteger JSDOptionSetIdForName( NSString *name )
+{
+    if (![name isKindOfClass:[NSString class]])
+    {
+        return N_TIDY_OPTIONS;
+    }
+
+    TidyOptionId optionId = tidyOptGetIdForName( [name UTF8String] );
+
+    if (optionId >= N_TIDY_OPTIONS || !JSDOptionSlots[optionId].known)
+    {
+        return N_TIDY_OPTIONS;
+    }
+
+    return optionId;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetApply
+ *   Sets a single option's value in a TidyDoc.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static void JSDOptionSetApply( const JSDTidyOptionValues *values, NSUInteger optionId, TidyDoc tidyDoc )
+{
+    switch (JSDOptionSlots[optionId].type)
+    {
+        case TidyBoolean:
+            tidyOptSetBool( tidyDoc, (TidyOptionId)optionId, JSDOptionSetBool(values, optionId) );
+            break;
+
+        case TidyInteger:
+            tidyOptSetInt( tidyDoc, (TidyOptionId)optionId, values->integers[optionId] );
+            break;
+
+        case TidyString:
+            if (values->strings[optionId].length == 0)
+            {
+                tidyOptSetValue( tidyDoc, (TidyOptionId)optionId, NULLSTR );
+            }
+            else
+            {
+                tidyOptSetValue( tidyDoc, (TidyOptionId)optionId, [values->strings[optionId] UTF8String] );
+            }
+            break;
+    }
+}
+
+
+#pragma mark - Implementation
+
+
+@implementation JSDTidyOptionSet
+{
+    JSDTidyOptionValues _values;
+}
+
+
+#pragma mark - Initialization
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithValues: (private, designated)
+ *   The fingerprint covers each option's value in id order: one
+ *   byte for Booleans, eight for integers, and the UTF-8 and a
+ *   terminator for strings. Nothing that varies between processes,
+ *   such as the string pointers, is included. The parse fingerprint
+ *   is the same, but skips the output-only options.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithValues:(const JSDTidyOptionValues *)values
+{
+    if (self = [super init])
+    {
+        memcpy(&_values, values, sizeof(_values));
+
+        uint64_t hash = JSDTidyFNVHashSeed;
+        uint64_t parseHash = hash;
+
+        for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+        {
+            if (!JSDOptionSlots[i].known)
+            {
+                continue;
+            }
+
+            uint8_t boolValue;
+            uint64_t integerValue;
+            const void *bytes;
+            size_t length;
+
+            if (JSDOptionSlots[i].type == TidyBoolean)
+            {
+                boolValue = JSDOptionSetBool(&_values, i);
+                bytes = &boolValue;
+                length = sizeof(boolValue);
+            }
+            else if (JSDOptionSlots[i].type == TidyInteger)
+            {
+                integerValue = _values.integers[i];
+                bytes = &integerValue;
+                length = sizeof(integerValue);
+            }
+            else
+            {
+                bytes = [(_values.strings[i] ?: @"") UTF8String];
+                length = strlen(bytes) + 1;
+            }
+
+            hash = JSDTidyFNVHash(hash, bytes, length);
+
+            if (!JSDOptionSlots[i].outputOnly)
+            {
+                parseHash = JSDTidyFNVHash(parseHash, bytes, length);
+            }
+        }
+
+        _fingerprint = hash;
+        _parseFingerprint = parseHash;
+    }
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - init
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)init
+{
+    JSDOptionSetLoadSlots();
+
+    return [self initWithValues:&JSDOptionDefaults];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithBuiltInDefaults
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithBuiltInDefaults
+{
+    static JSDTidyOptionSet *builtInDefaults = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        builtInDefaults = [[JSDTidyOptionSet alloc] init];
+    });
+
+    return builtInDefaults;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithDictionary:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithDictionary:(NSDictionary *)dictionary
+{
+    return [[self optionSetWithBuiltInDefaults] optionSetByMergingDictionary:dictionary];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithUserDefaults:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithUserDefaults:(NSUserDefaults *)defaults
+{
+    NSDictionary *dictionary = [defaults objectForKey:JSDKeyTidyTidyOptionsKey];
+
+    if (![dictionary isKindOfClass:[NSDictionary class]])
+    {
+        dictionary = nil;
+    }
+
+    return [self optionSetWithDictionary:dictionary];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDOptionSetEncodingForTidyName
+ *   The NSStringEncoding for one of libtidy's encoding names, or
+ *   zero for names without one, such as "raw".
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static NSStringEncoding JSDOptionSetEncodingForTidyName( NSString *name )
+{
+    static NSDictionary<NSString *, NSNumber *> *encodings = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        encodings = @{
+            @"ascii"    : @(NSASCIIStringEncoding),
+            @"latin0"   : @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingISOLatin9)),
+            @"latin1"   : @(NSISOLatin1StringEncoding),
+            @"utf8"     : @(NSUTF8StringEncoding),
+            @"iso2022"  : @(NSISO2022JPStringEncoding),
+            @"mac"      : @(NSMacOSRomanStringEncoding),
+            @"win1252"  : @(NSWindowsCP1252StringEncoding),
+            @"ibm858"   : @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingDOSLatin1)),
+            @"utf16le"  : @(NSUTF16LittleEndianStringEncoding),
+            @"utf16be"  : @(NSUTF16BigEndianStringEncoding),
+            @"utf16"    : @(NSUTF16StringEncoding),
+            @"big5"     : @(CFStringConvertEncodingToNSStringEncoding(kCFStringEncodingBig5)),
+            @"shiftjis" : @(NSShiftJISStringEncoding),
+        };
+    });
+
+    return [encodings[name.lowercaseString] unsignedIntegerValue];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithTidyDoc:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithTidyDoc:(TidyDoc)tidyDoc
+{
+    return [self optionSetWithTidyDoc:tidyDoc includingEncodings:NO];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithTidyDoc:includingEncodings:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithTidyDoc:(TidyDoc)tidyDoc includingEncodings:(BOOL)includeEncodings
+{
+    JSDOptionSetLoadSlots();
+
+    JSDTidyOptionValues values = JSDOptionDefaults;
+
+    for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+    {
+        const JSDTidyOptionSlot *slot = &JSDOptionSlots[i];
+
+        if (!slot->known || slot->readOnly)
+        {
+            continue;
+        }
+
+        if (slot->encoding)
+        {
+            if (includeEncodings)
+            {
+                ctmbstr value = tidyOptGetValue( tidyDoc, (TidyOptionId)i );
+                NSStringEncoding encoding = JSDOptionSetEncodingForTidyName( value ? @(value) : nil );
+
+                if (encoding)
+                {
+                    JSDOptionSetStore(&values, i, @(encoding));
+                }
+            }
+
+            continue;
+        }
+
+        if (slot->type == TidyBoolean)
+        {
+            JSDOptionSetStore(&values, i, tidyOptGetBool( tidyDoc, (TidyOptionId)i ) ? @"1" : @"0");
+        }
+        else if (slot->type == TidyInteger)
+        {
+            values.integers[i] = tidyOptGetInt( tidyDoc, (TidyOptionId)i );
+        }
+        else
+        {
+            ctmbstr value = tidyOptGetValue( tidyDoc, (TidyOptionId)i );
+            values.strings[i] = JSDOptionSetIntern( value ? @(value) : @"" );
+        }
+    }
+
+    return [[self alloc] initWithValues:&values];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithConfigFile:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithConfigFile:(NSURL *)fileURL
+{
+    return [self optionSetWithConfigFile:fileURL includingEncodings:NO];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithConfigFile:includingEncodings:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithConfigFile:(NSURL *)fileURL includingEncodings:(BOOL)includeEncodings
+{
+    JSDTidyOptionSet *result = nil;
+    TidyDoc newTidy = tidyCreate();
+
+    if ( tidyLoadConfig( newTidy, [fileURL fileSystemRepresentation] ) == 0 )
+    {
+        result = [self optionSetWithTidyDoc:newTidy includingEncodings:includeEncodings];
+    }
+
+    tidyRelease( newTidy );
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + optionSetWithTidyOptions: (private)
+ *   Used by JSDTidyModel. Suppressed options aren't applied to
+ *   TidyDocs, so they have their built-in defaults here.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (instancetype)optionSetWithTidyOptions:(NSArray *)options
+{
+    JSDOptionSetLoadSlots();
+
+    JSDTidyOptionValues values = JSDOptionDefaults;
+
+    for (JSDTidyOption *option in options)
+    {
+        NSUInteger optionId = option.optionId;
+
+        if (option.optionIsHeader || optionId >= N_TIDY_OPTIONS || !JSDOptionSlots[optionId].known)
+        {
+            continue;
+        }
+
+        if (!option.optionIsSuppressed)
+        {
+            JSDOptionSetStore(&values, optionId, option.optionValue);
+        }
+    }
+
+    return [[self alloc] initWithValues:&values];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - optionSetByMergingDictionary:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)optionSetByMergingDictionary:(NSDictionary *)dictionary
+{
+    if (dictionary.count == 0)
+    {
+        return self;
+    }
+
+    JSDTidyOptionValues values = _values;
+
+    for (NSString *name in dictionary)
+    {
+        NSUInteger optionId = JSDOptionSetIdForName(name);
+
+        if (optionId < N_TIDY_OPTIONS)
+        {
+            JSDOptionSetStore(&values, optionId, dictionary[name]);
+        }
+    }
+
+    return [[JSDTidyOptionSet alloc] initWithValues:&values];
+}
+
+
+#pragma mark - NSCopying
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - copyWithZone:
+ *   Option sets are immutable.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (id)copyWithZone:(NSZone *)zone
+{
+    return self;
+}
+
+
+#pragma mark - Option Values
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - valueForOptionName:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)valueForOptionName:(NSString *)name
+{
+    NSUInteger optionId = JSDOptionSetIdForName(name);
+
+    return (optionId < N_TIDY_OPTIONS) ? JSDOptionSetString(&_values, optionId) : nil;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - optionNamesDifferingFromOptionSet:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSArray<NSString *> *)optionNamesDifferingFromOptionSet:(JSDTidyOptionSet *)optionSet
+{
+    NSMutableArray *result = [[NSMutableArray alloc] init];
+
+    if (!optionSet)
+    {
+        optionSet = [JSDTidyOptionSet optionSetWithBuiltInDefaults];
+    }
+
+    if ([self isEqualToOptionSet:optionSet])
+    {
+        return result;
+    }
+
+    for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+    {
+        if (JSDOptionSlots[i].known && !JSDOptionSetSameValue(&_values, &optionSet->_values, i))
+        {
+            [result addObject:JSDOptionSlots[i].name];
+        }
+    }
+
+    return result;
+}
+
+
+#pragma mark - Object Comparison
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - isEqualToOptionSet:
+ *   Interned strings are equal only if they're the same pointer,
+ *   so the storage can be compared directly.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)isEqualToOptionSet:(JSDTidyOptionSet *)optionSet
+{
+    if (optionSet == self)
+    {
+        return YES;
+    }
+
+    if (!optionSet || optionSet->_fingerprint != _fingerprint)
+    {
+        return NO;
+    }
+
+    return memcmp(&_values, &optionSet->_values, sizeof(_values)) == 0;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - isEqual:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)isEqual:(id)object
+{
+    if (![object isKindOfClass:[JSDTidyOptionSet class]])
+    {
+        return NO;
+    }
+
+    return [self isEqualToOptionSet:(JSDTidyOptionSet *)object];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - hash
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)hash
+{
+    return (NSUInteger)_fingerprint;
+}
+
+
+#pragma mark - Conversions
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @dictionaryRepresentation
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSDictionary<NSString *, NSString *> *)dictionaryRepresentation
+{
+    NSMutableDictionary *result = [[NSMutableDictionary alloc] init];
+
+    for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+    {
+        if (JSDOptionSlots[i].known)
+        {
+            result[JSDOptionSlots[i].name] = JSDOptionSetString(&_values, i);
+        }
+    }
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - writeToUserDefaults:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)writeToUserDefaults:(NSUserDefaults *)defaults
+{
+    [defaults setObject:self.dictionaryRepresentation forKey:JSDKeyTidyTidyOptionsKey];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @configFileRepresentation
+ *   Enumerated values are written with their pick list names, as
+ *   with [JSDTidyOption optionConfigString].
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSString *)configFileRepresentation
+{
+    NSMutableArray *lines = [[NSMutableArray alloc] init];
+
+    for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+    {
+        const JSDTidyOptionSlot *slot = &JSDOptionSlots[i];
+
+        if (!slot->known || slot->readOnly)
+        {
+            continue;
+        }
+
+        NSString *value = JSDOptionSetString(&_values, i);
+
+        if (slot->encoding)
+        {
+            value = @"utf8";
+        }
+        else if (slot->type != TidyString && slot->pickList.count > 0)
+        {
+            unsigned long index = (slot->type == TidyBoolean) ? JSDOptionSetBool(&_values, i) : _values.integers[i];
+
+            if (index < slot->pickList.count)
+            {
+                value = slot->pickList[index];
+            }
+        }
+
+        [lines addObject:[NSString stringWithFormat:@"%@: %@\n", slot->name, value]];
+    }
+
+    [lines sortUsingSelector:@selector(caseInsensitiveCompare:)];
+
+    return [lines componentsJoinedByString:@""];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - applyToTidyDoc:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)applyToTidyDoc:(TidyDoc)tidyDoc
+{
+    for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+    {
+        const JSDTidyOptionSlot *slot = &JSDOptionSlots[i];
+        TidyOptionId optionId = (TidyOptionId)i;
+
+        if (!slot->known)
+        {
+            continue;
+        }
+
+        if (slot->encoding)
+        {
+            /* Force libtidy to use UTF8 internally. Mac OS X will handle
+             * file encoding and file input-output.
+             */
+            tidyOptSetValue( tidyDoc, optionId, "utf8" );
+            continue;
+        }
+
+        if (slot->readOnly)
+        {
+            continue;
+        }
+
+        JSDOptionSetApply(&_values, i, tidyDoc);
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - applyOutputOptionsToTidyDoc:
+ *   When libtidy parses, it adjusts a few of these options for the
+ *   printer: `wrap` 0 means no limit, and without `indent` there
+ *   are no indent spaces. We have to make the same adjustments,
+ *   because the document has already been parsed. `newline` is
+ *   left alone; runs always print LF.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)applyOutputOptionsToTidyDoc:(TidyDoc)tidyDoc
+{
+    for (NSUInteger i = 0; i < N_TIDY_OPTIONS; i++)
+    {
+        if (JSDOptionSlots[i].known && JSDOptionSlots[i].outputOnly && i != TidyNewline)
+        {
+            JSDOptionSetApply(&_values, i, tidyDoc);
+        }
+    }
+
+    unsigned long wrap = _values.integers[TidyWrapLen];
+
+    if (wrap == 0)
+    {
+        tidyOptSetInt( tidyDoc, TidyWrapLen, 0x7FFFFFFF );
+    }
+
+    if (_values.integers[TidyIndentContent] == TidyNoState)
+    {
+        tidyOptSetInt( tidyDoc, TidyIndentSpaces, 0 );
+    }
+}
+
+
+@end
@@ -0,0 +1,107 @@
+//
+//  JSDTidyPlatform.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+#include <time.h>
+
+
+/**
+ *  The few platform services that the AppKit-free parts of the framework
+ *  need, so that they can be built where there is no Darwin, too: a
+ *  lock, a monotonic clock, and little-endian reads.
+ */
+
+
+#pragma mark - Locks
+
+
+#if __has_include(<os/lock.h>)
+
+#include <os/lock.h>
+
+/**
+ *  A lock for short critical sections: @c os_unfair_lock on Darwin, and
+ *  a @c pthread_mutex_t elsewhere.
+ */
+typedef os_unfair_lock JSDTidyLock;
+
+/** The value to initialize a @c JSDTidyLock with. */
+#define JSDTidyLockInit OS_UNFAIR_LOCK_INIT
+
+static inline void JSDTidyLockLock( JSDTidyLock *lock )
+{
+    os_unfair_lock_lock(lock);
+}
+
+static inline void JSDTidyLockUnlock( JSDTidyLock *lock )
+{
+    os_unfair_lock_unlock(lock);
+}
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_mutex_t JSDTidyLock;
+
+#define JSDTidyLockInit ((pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER)
+
+static inline void JSDTidyLockLock( JSDTidyLock *lock )
+{
+    pthread_mutex_lock(lock);
+}
+
+static inline void JSDTidyLockUnlock( JSDTidyLock *lock )
+{
+    pthread_mutex_unlock(lock);
+}
+
+#endif
+
+
+#pragma mark - Time
+
+
+/**
+ *  The @c CLOCK_MONOTONIC time, in nanoseconds. Use it for deadlines and
+ *  for measuring elapsed time.
+ */
+static inline uint64_t JSDTidyMonotonicTime( void )
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+}
+
+
+#pragma mark - Byte Order
+
+
+/**
+ *  Converts little-endian values, such as those read from files, to the
+ *  host's byte order.
+ */
+static inline uint64_t JSDTidyLittleToHost64( uint64_t value )
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(value);
+#else
+    return value;
+#endif
+}
+
+static inline uint32_t JSDTidyLittleToHost32( uint32_t value )
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(value);
+#else
+    return value;
+#endif
+}
@@ -0,0 +1,140 @@
+//
+//  JSDTidyResultCache.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+
+/**
+ *  @c JSDTidyResultCache remembers the results of recent tidying
+ *  operations: the tidy text, the messages, and the status counters. A
+ *  result is identified by a hash of the source bytes, the fingerprint of
+ *  the options, and the @b libtidy version, so when @c JSDTidyModel is
+ *  asked to tidy something it has already tidied (undo, reverting an
+ *  option, switching between documents with the same content), it uses
+ *  the cached result instead of parsing again.
+ *
+ *  When the total size of the results would exceed @c memoryLimit, the
+ *  least recently used results are discarded.
+ *
+ *  Caches are safe to use from any thread, and can be shared by any
+ *  number of models.
+ */
+@interface JSDTidyResultCache : NSObject
+
+
+#pragma mark - Creating Caches
+
+
+/**
+ *  The cache that new @c JSDTidyModel instances use by default.
+ */
++ (JSDTidyResultCache *)sharedCache;
+
+/**
+ *  Initializes a cache that holds up to @c memoryLimit bytes of results.
+ *
+ *  @param memoryLimit The number of bytes that the results may occupy.
+ */
+- (instancetype)initWithMemoryLimit:(NSUInteger)memoryLimit NS_DESIGNATED_INITIALIZER;
+
+
+#pragma mark - Memory Budget
+
+
+/**
+ *  The approximate number of bytes that the cached results may occupy.
+ *  Reducing this discards results immediately if needed, and a limit of
+ *  zero keeps nothing in memory. The default for the shared cache is 32 MB.
+ */
+@property (atomic, assign) NSUInteger memoryLimit;
+
+/**
+ *  The approximate number of bytes that the cached results occupy.
+ */
+@property (atomic, assign, readonly) NSUInteger totalCost;
+
+/**
+ *  The number of results in the cache.
+ */
+@property (atomic, assign, readonly) NSUInteger resultCount;
+
+/**
+ *  Discards all of the cached results, including those in
+ *  @c persistentStoreURL. The statistics are unaffected.
+ */
+- (void)removeAllResults;
+
+
+#pragma mark - Persistent Storage
+
+
+/**
+ *  A directory in which results are also kept on disk, so that they
+ *  survive from one launch to the next, and so that batch jobs over large
+ *  trees of files can reuse the results of earlier passes. When a result
+ *  isn't in memory, it's read from this directory if it's there.
+ *
+ *  Results are stored per @b libtidy version, in a subdirectory that the
+ *  cache creates; results from other versions are deleted when the
+ *  directory is set. Nothing else in the directory is ever touched, and
+ *  it's limited by @c persistentStoreLimit rather than @c memoryLimit.
+ *  The default is @c nil, meaning that results are only kept in memory.
+ */
+@property (atomic, strong) NSURL *persistentStoreURL;
+
+/**
+ *  The approximate number of bytes that the results in
+ *  @c persistentStoreURL may occupy. When they exceed it, the oldest
+ *  results are deleted. Zero means no limit. The default is 256 MB.
+ */
+@property (atomic, assign) NSUInteger persistentStoreLimit;
+
+/**
+ *  Waits until all of the results stored so far have been written to
+ *  @c persistentStoreURL. Results are written in the background, so
+ *  call this before a batch job exits.
+ */
+- (void)synchronizePersistentStore;
+
+
+#pragma mark - Statistics
+
+
+/**
+ *  The number of lookups that found a result.
+ */
+@property (atomic, assign, readonly) NSUInteger hitCount;
+
+/**
+ *  The number of lookups that found a result in @c persistentStoreURL
+ *  rather than in memory. These are included in @c hitCount.
+ */
+@property (atomic, assign, readonly) NSUInteger persistentHitCount;
+
+/**
+ *  The number of lookups that didn't find a result.
+ */
+@property (atomic, assign, readonly) NSUInteger missCount;
+
+/**
+ *  The number of results that were discarded to stay within
+ *  @c memoryLimit.
+ */
+@property (atomic, assign, readonly) NSUInteger evictionCount;
+
+/**
+ *  The fraction of lookups that found a result, from 0.0 to 1.0.
+ */
+@property (atomic, assign, readonly) double hitRate;
+
+/**
+ *  Sets the hit, persistent hit, miss, and eviction counts to zero.
+ */
+- (void)resetStatistics;
+
+
+@end
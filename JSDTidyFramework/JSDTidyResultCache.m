@@ -0,0 +1,503 @@
+//
+//  JSDTidyResultCache.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyResultCache.h"
+#import "JSDTidyCachedResult.h"
+#import "JSDTidyResultStore.h"
+#import "JSDTidyPlatform.h"
+
+
+#pragma mark - Definitions
+
+
+/* The shared cache's default budget. */
+
+static const NSUInteger JSDTidyResultCacheDefaultLimit = 32 * 1024 * 1024;
+
+
+/* The default budget for the persistent store. */
+
+static const NSUInteger JSDTidyResultCacheDefaultStoreLimit = 256 * 1024 * 1024;
+
+
+/* A single result may use at most this fraction of the budget, so that
+ * one huge document can't flush everything else.
+ */
+
+static const NSUInteger JSDTidyResultCacheEntryDivisor = 4;
+
+
+#pragma mark - Implementation
+
+
+@implementation JSDTidyResultCache
+{
+    JSDTidyLock _lock;
+    NSMutableDictionary<NSData *, JSDTidyCachedResult *> *_results;  // Keyed by JSDTidyResultKey bytes.
+    JSDTidyCachedResult *_newest;                                    // Head of the recently used list.
+    JSDTidyCachedResult *_oldest;                                    // Tail; evicted first.
+    NSUInteger _memoryLimit;
+    NSUInteger _totalCost;
+    JSDTidyResultStore *_store;                                      // Optional; see persistentStoreURL.
+    NSUInteger _persistentStoreLimit;
+    NSUInteger _hitCount;
+    NSUInteger _persistentHitCount;
+    NSUInteger _missCount;
+    NSUInteger _evictionCount;
+}
+
+
+#pragma mark - Initialization
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * + sharedCache
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
++ (JSDTidyResultCache *)sharedCache
+{
+    static JSDTidyResultCache *sharedCache;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        sharedCache = [[JSDTidyResultCache alloc] initWithMemoryLimit:JSDTidyResultCacheDefaultLimit];
+    });
+
+    return sharedCache;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - init
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)init
+{
+    return [self initWithMemoryLimit:JSDTidyResultCacheDefaultLimit];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithMemoryLimit:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithMemoryLimit:(NSUInteger)memoryLimit
+{
+    if (self = [super init])
+    {
+        _lock = JSDTidyLockInit;
+        _results = [[NSMutableDictionary alloc] init];
+        _memoryLimit = memoryLimit;
+        _persistentStoreLimit = JSDTidyResultCacheDefaultStoreLimit;
+    }
+
+    return self;
+}
+
+
+#pragma mark - Memory Budget
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @memoryLimit
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)memoryLimit
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger memoryLimit = _memoryLimit;
+    JSDTidyLockUnlock(&_lock);
+
+    return memoryLimit;
+}
+
+- (void)setMemoryLimit:(NSUInteger)memoryLimit
+{
+    JSDTidyLockLock(&_lock);
+    _memoryLimit = memoryLimit;
+    [self evictToCost:memoryLimit];
+    JSDTidyLockUnlock(&_lock);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @totalCost
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)totalCost
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger totalCost = _totalCost;
+    JSDTidyLockUnlock(&_lock);
+
+    return totalCost;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @resultCount
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)resultCount
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger resultCount = _results.count;
+    JSDTidyLockUnlock(&_lock);
+
+    return resultCount;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - removeAllResults
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)removeAllResults
+{
+    JSDTidyLockLock(&_lock);
+
+    /* Release the results outside of the lock. */
+
+    NSMutableDictionary *results = _results;
+
+    _results = [[NSMutableDictionary alloc] init];
+    _newest = nil;
+    _oldest = nil;
+    _totalCost = 0;
+
+    JSDTidyResultStore *store = _store;
+
+    JSDTidyLockUnlock(&_lock);
+
+    results = nil;
+
+    [store removeAllResults];
+}
+
+
+#pragma mark - Persistent Storage
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @persistentStoreURL
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSURL *)persistentStoreURL
+{
+    JSDTidyLockLock(&_lock);
+    NSURL *persistentStoreURL = _store.directoryURL;
+    JSDTidyLockUnlock(&_lock);
+
+    return persistentStoreURL;
+}
+
+- (void)setPersistentStoreURL:(NSURL *)persistentStoreURL
+{
+    /* Opening the store reads its index, so do it outside of the lock. */
+
+    JSDTidyResultStore *store = nil;
+
+    if (persistentStoreURL)
+    {
+        store = [[JSDTidyResultStore alloc] initWithDirectoryURL:persistentStoreURL byteLimit:self.persistentStoreLimit];
+
+        if (!store)
+        {
+            NSLog(@"JSDTidyResultCache: unable to use %@ for persistent storage.", persistentStoreURL.path);
+        }
+    }
+
+    JSDTidyLockLock(&_lock);
+    _store = store;
+    JSDTidyLockUnlock(&_lock);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @persistentStoreLimit
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)persistentStoreLimit
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger persistentStoreLimit = _persistentStoreLimit;
+    JSDTidyLockUnlock(&_lock);
+
+    return persistentStoreLimit;
+}
+
+- (void)setPersistentStoreLimit:(NSUInteger)persistentStoreLimit
+{
+    JSDTidyLockLock(&_lock);
+    _persistentStoreLimit = persistentStoreLimit;
+    JSDTidyResultStore *store = _store;
+    JSDTidyLockUnlock(&_lock);
+
+    store.byteLimit = persistentStoreLimit;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - synchronizePersistentStore
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)synchronizePersistentStore
+{
+    [[self store] synchronize];
+}
+
+
+#pragma mark - Statistics
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @hitCount, @persistentHitCount, @missCount, @evictionCount
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)hitCount
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger hitCount = _hitCount;
+    JSDTidyLockUnlock(&_lock);
+
+    return hitCount;
+}
+
+- (NSUInteger)persistentHitCount
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger persistentHitCount = _persistentHitCount;
+    JSDTidyLockUnlock(&_lock);
+
+    return persistentHitCount;
+}
+
+- (NSUInteger)missCount
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger missCount = _missCount;
+    JSDTidyLockUnlock(&_lock);
+
+    return missCount;
+}
+
+- (NSUInteger)evictionCount
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger evictionCount = _evictionCount;
+    JSDTidyLockUnlock(&_lock);
+
+    return evictionCount;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @hitRate
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (double)hitRate
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger lookups = _hitCount + _missCount;
+    double hitRate = lookups ? (double)_hitCount / (double)lookups : 0.0;
+    JSDTidyLockUnlock(&_lock);
+
+    return hitRate;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - resetStatistics
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)resetStatistics
+{
+    JSDTidyLockLock(&_lock);
+    _hitCount = 0;
+    _persistentHitCount = 0;
+    _missCount = 0;
+    _evictionCount = 0;
+    JSDTidyLockUnlock(&_lock);
+}
+
+
+#pragma mark - Lookup and Storage
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - resultForKey:
+ *   Results read from the persistent store are kept in memory
+ *   too, so the next lookup doesn't go to the disk.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyCachedResult *)resultForKey:(JSDTidyResultKey)key
+{
+    NSData *keyData = [[NSData alloc] initWithBytes:&key length:sizeof(key)];
+
+    JSDTidyLockLock(&_lock);
+
+    JSDTidyCachedResult *result = _results[keyData];
+    JSDTidyResultStore *store = _store;
+
+    if (result)
+    {
+        _hitCount++;
+        [self unlinkResult:result];
+        [self linkNewestResult:result];
+    }
+
+    JSDTidyLockUnlock(&_lock);
+
+    if (result)
+    {
+        return result;
+    }
+
+    result = [store resultForKey:key];
+
+    JSDTidyLockLock(&_lock);
+
+    if (result)
+    {
+        _hitCount++;
+        _persistentHitCount++;
+    }
+    else
+    {
+        _missCount++;
+    }
+
+    JSDTidyLockUnlock(&_lock);
+
+    if (result)
+    {
+        [self keepResult:result];
+    }
+
+    return result;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - storeResult:
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)storeResult:(JSDTidyCachedResult *)result
+{
+    [self keepResult:result];
+
+    [[self store] storeResult:result];
+}
+
+
+#pragma mark - Private
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - store (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyResultStore *)store
+{
+    JSDTidyLockLock(&_lock);
+    JSDTidyResultStore *store = _store;
+    JSDTidyLockUnlock(&_lock);
+
+    return store;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - keepResult: (private)
+ *   Adds a result to memory only. The cost is computed before
+ *   taking the lock; it doesn't change once a result is stored.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)keepResult:(JSDTidyCachedResult *)result
+{
+    JSDTidyResultKey key = result.key;
+    NSData *keyData = [[NSData alloc] initWithBytes:&key length:sizeof(key)];
+    NSUInteger cost = result.cost;
+
+    JSDTidyLockLock(&_lock);
+
+    if (cost <= _memoryLimit / JSDTidyResultCacheEntryDivisor)
+    {
+        JSDTidyCachedResult *existing = _results[keyData];
+
+        if (existing)
+        {
+            [self unlinkResult:existing];
+            _totalCost -= existing.cost;
+        }
+
+        [self evictToCost:_memoryLimit - cost];
+
+        _results[keyData] = result;
+        _totalCost += cost;
+        [self linkNewestResult:result];
+    }
+
+    JSDTidyLockUnlock(&_lock);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - evictToCost: (private)
+ *   Discards the oldest results until the total is no more than
+ *   `cost`. Must be called with the lock held.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)evictToCost:(NSUInteger)cost
+{
+    while (_oldest && _totalCost > cost)
+    {
+        JSDTidyCachedResult *victim = _oldest;
+        JSDTidyResultKey key = victim.key;
+
+        [self unlinkResult:victim];
+        _totalCost -= victim.cost;
+        _evictionCount++;
+
+        [_results removeObjectForKey:[[NSData alloc] initWithBytes:&key length:sizeof(key)]];
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - unlinkResult: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)unlinkResult:(JSDTidyCachedResult *)result
+{
+    if (result.newer)
+    {
+        result.newer.older = result.older;
+    }
+    else
+    {
+        _newest = result.older;
+    }
+
+    if (result.older)
+    {
+        result.older.newer = result.newer;
+    }
+    else
+    {
+        _oldest = result.newer;
+    }
+
+    result.newer = nil;
+    result.older = nil;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - linkNewestResult: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)linkNewestResult:(JSDTidyCachedResult *)result
+{
+    result.older = _newest;
+    result.newer = nil;
+
+    if (_newest)
+    {
+        _newest.newer = result;
+    }
+
+    _newest = result;
+
+    if (!_oldest)
+    {
+        _oldest = result;
+    }
+}
+
+
+@end
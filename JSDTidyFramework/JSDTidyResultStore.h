@@ -0,0 +1,82 @@
+//
+//  JSDTidyResultStore.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+#import "JSDTidyCachedResult.h"
+
+
+/**
+ *  @c JSDTidyResultStore is the on-disk backing for a
+ *  @c JSDTidyResultCache. Each result is a blob file named for its key,
+ *  which is memory mapped when it's read, so that a result's tidy text is
+ *  never copied. A compact index of the keys that are present is kept in
+ *  memory and appended to on disk, so a lookup for a result that isn't
+ *  stored never touches the file system.
+ *
+ *  Results are kept in a subdirectory for the current @b libtidy version,
+ *  inside a subdirectory of @c directoryURL that the store owns; the
+ *  subdirectories for other versions are deleted when a store is opened.
+ *  Nothing else in @c directoryURL is ever touched.
+ *
+ *  When the stored results exceed @c byteLimit, the oldest are deleted.
+ *
+ *  Stores are safe to use from any thread. Results are written in the
+ *  background, in the order that they're stored.
+ */
+@interface JSDTidyResultStore : NSObject
+
+
+/**
+ *  Opens or creates a store in @c directoryURL.
+ *
+ *  @param directoryURL The directory in which to keep the store.
+ *  @param byteLimit The initial @c byteLimit.
+ *  @returns Returns the store, or @c nil if the directory couldn't be
+ *    created.
+ */
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL byteLimit:(NSUInteger)byteLimit;
+
+/**
+ *  The directory given to @c initWithDirectoryURL:byteLimit:.
+ */
+@property (nonatomic, strong, readonly) NSURL *directoryURL;
+
+/**
+ *  The number of bytes that the stored results may occupy on disk. When
+ *  they exceed it, the results that were stored first are deleted until
+ *  they occupy three quarters of it. Zero means no limit.
+ */
+@property (atomic, assign) NSUInteger byteLimit;
+
+/**
+ *  The number of bytes that the stored results occupy on disk.
+ */
+@property (atomic, assign, readonly) NSUInteger storedBytes;
+
+/**
+ *  Reads the result for @c key, or returns @c nil if it isn't stored.
+ */
+- (JSDTidyCachedResult *)resultForKey:(JSDTidyResultKey)key;
+
+/**
+ *  Writes @c result in the background, unless its key is already stored.
+ */
+- (void)storeResult:(JSDTidyCachedResult *)result;
+
+/**
+ *  Deletes all of the stored results.
+ */
+- (void)removeAllResults;
+
+/**
+ *  Waits until all of the results stored so far have been written.
+ */
+- (void)synchronize;
+
+
+@end
@@ -0,0 +1,652 @@
+//
+//  JSDTidyResultStore.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyResultStore.h"
+#import "JSDTidyPlatform.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+#pragma mark - Definitions
+
+
+#define JSDResultBlobMagic   ((uint32_t)0x42594454)  // 'TDYB'
+#define JSDResultBlobVersion ((uint32_t)1)
+
+static NSString * const JSDResultStoreRootName  = @"JSDTidyResults";
+static NSString * const JSDResultStoreIndexName = @"index";
+static NSString * const JSDResultStoreBlobsName = @"blobs";
+
+
+/* Eviction goes below the limit, so that it isn't needed again as soon
+ * as the next result is stored.
+ */
+#define JSDResultStoreEvictionNumerator   3
+#define JSDResultStoreEvictionDenominator 4
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyResultIndexRecord
+ *   The index file is a sequence of these, oldest first.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDTidyResultIndexRecord {
+    JSDTidyResultKey key;
+    uint64_t blobLength;
+} JSDTidyResultIndexRecord;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyResultBlobHeader
+ *   A blob is this header, followed by the tidy text, the error
+ *   text, and the message list archive.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDTidyResultBlobHeader {
+    uint32_t magic;
+    uint32_t version;
+    JSDTidyResultKey key;
+    int32_t  tidyDetectedHtmlVersion;
+    uint8_t  tidyDetectedXhtml;
+    uint8_t  tidyDetectedGenericXml;
+    uint16_t reserved;
+    int32_t  tidyStatus;
+    uint32_t tidyErrorCount;
+    uint32_t tidyWarningCount;
+    uint32_t tidyAccessWarningCount;
+    uint64_t tidyDataLength;
+    uint64_t errorTextLength;
+    uint64_t messagesLength;
+} JSDTidyResultBlobHeader;
+
+
+#pragma mark - Implementation
+
+
+@implementation JSDTidyResultStore
+{
+    JSDTidyLock _lock;
+    NSURL *_versionURL;                 // Results for the current libtidy.
+    NSMutableDictionary<NSData *, NSNumber *> *_blobLengths;  // By JSDTidyResultKey bytes of every stored result.
+    NSMutableOrderedSet<NSData *> *_storedOrder;              // The same keys, oldest first.
+    NSMutableSet<NSData *> *_pendingKeys;  // Queued to be written.
+    NSUInteger _storedBytes;
+    NSUInteger _byteLimit;
+    int _indexFile;                     // Appended to on `_writeQueue`.
+    dispatch_queue_t _writeQueue;
+}
+
+
+#pragma mark - Initialization and Deallocation
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - initWithDirectoryURL:byteLimit:
+ *   The directory may be anything a user chose, so the store keeps
+ *   to a subdirectory of its own.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (instancetype)initWithDirectoryURL:(NSURL *)directoryURL byteLimit:(NSUInteger)byteLimit
+{
+    if (!(self = [super init]))
+    {
+        return nil;
+    }
+
+    _lock = JSDTidyLockInit;
+    _directoryURL = directoryURL;
+    _blobLengths = [[NSMutableDictionary alloc] init];
+    _storedOrder = [[NSMutableOrderedSet alloc] init];
+    _pendingKeys = [[NSMutableSet alloc] init];
+    _byteLimit = byteLimit;
+    _indexFile = -1;
+    _writeQueue = dispatch_queue_create("com.balthisar.JSDTidyResultStore.write", DISPATCH_QUEUE_SERIAL);
+
+    NSString *version = [NSString stringWithFormat:@"%016llx", JSDTidyLibraryHash()];
+    NSURL *rootURL = [directoryURL URLByAppendingPathComponent:JSDResultStoreRootName isDirectory:YES];
+
+    _versionURL = [rootURL URLByAppendingPathComponent:version isDirectory:YES];
+
+
+    /* Results from any other version of libtidy are useless now. */
+
+    [self removeVersionDirectoriesInURL:rootURL exceptVersion:version];
+
+    if (![self openIndex])
+    {
+        return nil;
+    }
+
+    dispatch_async(_writeQueue, ^{
+        [self evictToByteLimit];
+    });
+
+    return self;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - dealloc
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)dealloc
+{
+    if (_indexFile >= 0)
+    {
+        close(_indexFile);
+    }
+}
+
+
+#pragma mark - Byte Limit
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @byteLimit
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)byteLimit
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger byteLimit = _byteLimit;
+    JSDTidyLockUnlock(&_lock);
+
+    return byteLimit;
+}
+
+- (void)setByteLimit:(NSUInteger)byteLimit
+{
+    JSDTidyLockLock(&_lock);
+    _byteLimit = byteLimit;
+    JSDTidyLockUnlock(&_lock);
+
+    dispatch_async(_writeQueue, ^{
+        [self evictToByteLimit];
+    });
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * @storedBytes
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSUInteger)storedBytes
+{
+    JSDTidyLockLock(&_lock);
+    NSUInteger storedBytes = _storedBytes;
+    JSDTidyLockUnlock(&_lock);
+
+    return storedBytes;
+}
+
+
+#pragma mark - Reading
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - resultForKey:
+ *   The tidy text refers directly to the mapped blob, which
+ *   stays mapped for as long as the text is in use.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (JSDTidyCachedResult *)resultForKey:(JSDTidyResultKey)key
+{
+    NSData *keyData = [[NSData alloc] initWithBytes:&key length:sizeof(key)];
+
+    JSDTidyLockLock(&_lock);
+    BOOL isStored = _blobLengths[keyData] != nil;
+    JSDTidyLockUnlock(&_lock);
+
+    if (!isStored)
+    {
+        return nil;
+    }
+
+    NSURL *blobURL = [self blobURLForKey:key];
+    NSData *blob = [[NSData alloc] initWithContentsOfURL:blobURL options:NSDataReadingMappedIfSafe error:nil];
+
+    JSDTidyResultBlobHeader header;
+
+    if (blob.length >= sizeof(header))
+    {
+        memcpy(&header, blob.bytes, sizeof(header));
+    }
+
+    if (blob.length < sizeof(header) ||
+        header.magic != JSDResultBlobMagic ||
+        header.version != JSDResultBlobVersion ||
+        memcmp(&header.key, &key, sizeof(key)) != 0 ||
+        blob.length != sizeof(header) + header.tidyDataLength + header.errorTextLength + header.messagesLength)
+    {
+        [self forgetKey:keyData];
+        return nil;
+    }
+
+    const uint8_t *tidyBytes = (const uint8_t *)blob.bytes + sizeof(header);
+    const uint8_t *errorBytes = tidyBytes + header.tidyDataLength;
+    const uint8_t *messageBytes = errorBytes + header.errorTextLength;
+
+    JSDTidyMessageList *errorArray = [[JSDTidyMessageList alloc] initWithArchive:messageBytes length:(NSUInteger)header.messagesLength];
+    NSString *errorText = [[NSString alloc] initWithBytes:errorBytes length:(NSUInteger)header.errorTextLength encoding:NSUTF8StringEncoding];
+
+    if (!errorArray || !errorText)
+    {
+        [self forgetKey:keyData];
+        return nil;
+    }
+
+    JSDTidyCachedResult *result = [[JSDTidyCachedResult alloc] init];
+
+    result.key                     = key;
+    result.errorText               = errorText;
+    result.errorArray              = errorArray;
+    result.tidyDetectedHtmlVersion = header.tidyDetectedHtmlVersion;
+    result.tidyDetectedXhtml       = header.tidyDetectedXhtml;
+    result.tidyDetectedGenericXml  = header.tidyDetectedGenericXml;
+    result.tidyStatus              = header.tidyStatus;
+    result.tidyErrorCount          = header.tidyErrorCount;
+    result.tidyWarningCount        = header.tidyWarningCount;
+    result.tidyAccessWarningCount  = header.tidyAccessWarningCount;
+
+    result.tidyData = [[NSData alloc] initWithBytesNoCopy:(void *)tidyBytes
+                                                   length:(NSUInteger)header.tidyDataLength
+                                              deallocator:^(void *bytes, NSUInteger length) {
+                                                  (void)blob;
+                                              }];
+
+    return result;
+}
+
+
+#pragma mark - Writing
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - storeResult:
+ *   The key is claimed right away, so that the same result isn't
+ *   queued twice. The blob is written before its key is added to
+ *   the index file, so the index never names a partial blob.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)storeResult:(JSDTidyCachedResult *)result
+{
+    JSDTidyResultKey key = result.key;
+    NSData *keyData = [[NSData alloc] initWithBytes:&key length:sizeof(key)];
+
+    JSDTidyLockLock(&_lock);
+
+    BOOL isStored = _blobLengths[keyData] != nil || [_pendingKeys containsObject:keyData];
+
+    if (!isStored)
+    {
+        [_pendingKeys addObject:keyData];
+    }
+
+    JSDTidyLockUnlock(&_lock);
+
+    if (isStored)
+    {
+        return;
+    }
+
+    dispatch_async(_writeQueue, ^{
+
+        NSData *blob = [self blobForResult:result];
+        NSURL *blobURL = [self blobURLForKey:key];
+
+        [[NSFileManager defaultManager] createDirectoryAtURL:[blobURL URLByDeletingLastPathComponent]
+                                 withIntermediateDirectories:YES
+                                                  attributes:nil
+                                                       error:nil];
+
+        BOOL didWrite = [blob writeToURL:blobURL options:NSDataWritingAtomic error:nil];
+
+        JSDTidyResultIndexRecord record = { key, blob.length };
+
+        if (didWrite)
+        {
+            didWrite = [self appendIndexRecord:&record];
+
+            if (!didWrite)
+            {
+                [[NSFileManager defaultManager] removeItemAtURL:blobURL error:nil];
+            }
+        }
+
+        JSDTidyLockLock(&self->_lock);
+
+        [self->_pendingKeys removeObject:keyData];
+
+        if (didWrite)
+        {
+            [self addRecord:&record];
+        }
+
+        JSDTidyLockUnlock(&self->_lock);
+
+        [self evictToByteLimit];
+    });
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - removeAllResults
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)removeAllResults
+{
+    dispatch_sync(_writeQueue, ^{
+
+        if (self->_indexFile >= 0)
+        {
+            close(self->_indexFile);
+            self->_indexFile = -1;
+        }
+
+        [[NSFileManager defaultManager] removeItemAtURL:self->_versionURL error:nil];
+
+        JSDTidyLockLock(&self->_lock);
+        [self->_blobLengths removeAllObjects];
+        [self->_storedOrder removeAllObjects];
+        self->_storedBytes = 0;
+        JSDTidyLockUnlock(&self->_lock);
+
+        [self openIndex];
+    });
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - synchronize
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)synchronize
+{
+    dispatch_sync(_writeQueue, ^{});
+}
+
+
+#pragma mark - Private
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - openIndex (private)
+ *   Creates the version directory if needed, reads the records
+ *   from the index, and opens the index for appending. A partial
+ *   record at the end, from a write that was cut short, is cut off,
+ *   so that the records appended after it line up.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)openIndex
+{
+    NSURL *blobsURL = [_versionURL URLByAppendingPathComponent:JSDResultStoreBlobsName isDirectory:YES];
+
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:blobsURL withIntermediateDirectories:YES attributes:nil error:nil])
+    {
+        return NO;
+    }
+
+    NSURL *indexURL = [_versionURL URLByAppendingPathComponent:JSDResultStoreIndexName isDirectory:NO];
+    NSData *index = [[NSData alloc] initWithContentsOfURL:indexURL options:NSDataReadingMappedIfSafe error:nil];
+    NSUInteger count = index.length / sizeof(JSDTidyResultIndexRecord);
+    const JSDTidyResultIndexRecord *records = index.bytes;
+
+    JSDTidyLockLock(&_lock);
+
+    for (NSUInteger i = 0; i < count; i++)
+    {
+        JSDTidyResultIndexRecord record;
+
+        memcpy(&record, &records[i], sizeof(record));
+
+        [self addRecord:&record];
+    }
+
+    JSDTidyLockUnlock(&_lock);
+
+    _indexFile = open(indexURL.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+
+    if (_indexFile >= 0 && index.length != count * sizeof(JSDTidyResultIndexRecord))
+    {
+        if (ftruncate(_indexFile, (off_t)(count * sizeof(JSDTidyResultIndexRecord))) != 0)
+        {
+            close(_indexFile);
+            _indexFile = -1;
+        }
+    }
+
+    return _indexFile >= 0;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - appendIndexRecord: (private)
+ *   Called on the write queue. If the record can't be written in
+ *   full, whatever part of it was written is cut off again.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (BOOL)appendIndexRecord:(const JSDTidyResultIndexRecord *)record
+{
+    if (_indexFile < 0)
+    {
+        return NO;
+    }
+
+    off_t length = lseek(_indexFile, 0, SEEK_END);
+
+    if (write(_indexFile, record, sizeof(*record)) == (ssize_t)sizeof(*record))
+    {
+        return YES;
+    }
+
+    if (length < 0 || ftruncate(_indexFile, length) != 0)
+    {
+        /* The index can't be trusted to line up anymore. */
+        close(_indexFile);
+        _indexFile = -1;
+    }
+
+    return NO;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - forgetKey: (private)
+ *   For blobs that have gone missing or are damaged. The key stays
+ *   in the index file, but a later store replaces the blob.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)forgetKey:(NSData *)keyData
+{
+    JSDTidyLockLock(&_lock);
+    [self removeRecordForKeyData:keyData];
+    JSDTidyLockUnlock(&_lock);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - addRecord: (private)
+ *   Must be called with the lock held. A key that's stored again
+ *   becomes the newest.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)addRecord:(const JSDTidyResultIndexRecord *)record
+{
+    NSData *keyData = [[NSData alloc] initWithBytes:&record->key length:sizeof(record->key)];
+
+    [self removeRecordForKeyData:keyData];
+
+    _blobLengths[keyData] = @(record->blobLength);
+    [_storedOrder addObject:keyData];
+    _storedBytes += (NSUInteger)record->blobLength;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - removeRecordForKeyData: (private)
+ *   Must be called with the lock held.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)removeRecordForKeyData:(NSData *)keyData
+{
+    NSNumber *blobLength = _blobLengths[keyData];
+
+    if (blobLength)
+    {
+        _storedBytes -= blobLength.unsignedIntegerValue;
+        [_blobLengths removeObjectForKey:keyData];
+        [_storedOrder removeObject:keyData];
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - evictToByteLimit (private)
+ *   Runs on `_writeQueue`. The oldest results are forgotten under
+ *   the lock, then their blobs are deleted, and the index is
+ *   rewritten without them. Blobs that are mapped by results in
+ *   use stay readable until they're unmapped.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)evictToByteLimit
+{
+    NSMutableArray<NSData *> *evicted = [[NSMutableArray alloc] init];
+    NSMutableData *index = nil;
+
+    JSDTidyLockLock(&_lock);
+
+    if (_byteLimit > 0 && _storedBytes > _byteLimit)
+    {
+        NSUInteger target = _byteLimit / JSDResultStoreEvictionDenominator * JSDResultStoreEvictionNumerator;
+
+        while (_storedBytes > target && _storedOrder.count > 0)
+        {
+            NSData *keyData = _storedOrder.firstObject;
+
+            [evicted addObject:keyData];
+            [self removeRecordForKeyData:keyData];
+        }
+
+        index = [[NSMutableData alloc] initWithCapacity:_storedOrder.count * sizeof(JSDTidyResultIndexRecord)];
+
+        for (NSData *keyData in _storedOrder)
+        {
+            JSDTidyResultIndexRecord record;
+
+            memcpy(&record.key, keyData.bytes, sizeof(record.key));
+            record.blobLength = _blobLengths[keyData].unsignedLongLongValue;
+
+            [index appendBytes:&record length:sizeof(record)];
+        }
+    }
+
+    JSDTidyLockUnlock(&_lock);
+
+    if (!index)
+    {
+        return;
+    }
+
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+
+    for (NSData *keyData in evicted)
+    {
+        JSDTidyResultKey key;
+
+        memcpy(&key, keyData.bytes, sizeof(key));
+
+        [fileManager removeItemAtURL:[self blobURLForKey:key] error:nil];
+    }
+
+    NSURL *indexURL = [_versionURL URLByAppendingPathComponent:JSDResultStoreIndexName isDirectory:NO];
+
+    if (_indexFile >= 0)
+    {
+        close(_indexFile);
+    }
+
+    [index writeToURL:indexURL options:NSDataWritingAtomic error:nil];
+
+    _indexFile = open(indexURL.fileSystemRepresentation, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - removeVersionDirectoriesInURL:exceptVersion: (private)
+ *   Only removes what is certainly a version directory: sixteen
+ *   hexadecimal digits, containing an index.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (void)removeVersionDirectoriesInURL:(NSURL *)directoryURL exceptVersion:(NSString *)version
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSCharacterSet *nonHexCharacters = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdef"] invertedSet];
+
+    for (NSURL *url in [fileManager contentsOfDirectoryAtURL:directoryURL includingPropertiesForKeys:nil options:0 error:nil])
+    {
+        NSString *name = url.lastPathComponent;
+
+        if (name.length != 16 ||
+            [name rangeOfCharacterFromSet:nonHexCharacters].location != NSNotFound ||
+            [name isEqualToString:version])
+        {
+            continue;
+        }
+
+        NSURL *indexURL = [url URLByAppendingPathComponent:JSDResultStoreIndexName isDirectory:NO];
+
+        if ([fileManager fileExistsAtPath:indexURL.path])
+        {
+            [fileManager removeItemAtURL:url error:nil];
+        }
+    }
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - blobURLForKey: (private)
+ *   Blobs are spread over 256 directories by the first byte of
+ *   the source hash, to keep the directories small.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSURL *)blobURLForKey:(JSDTidyResultKey)key
+{
+    NSString *path = [NSString stringWithFormat:@"%@/%02llx/%016llx-%llx-%016llx",
+                      JSDResultStoreBlobsName,
+                      key.sourceHash >> 56,
+                      key.sourceHash,
+                      key.sourceLength,
+                      key.optionsFingerprint];
+
+    return [_versionURL URLByAppendingPathComponent:path isDirectory:NO];
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * - blobForResult: (private)
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+- (NSData *)blobForResult:(JSDTidyCachedResult *)result
+{
+    const char *errorText = result.errorText.UTF8String ?: "";
+
+    NSMutableData *messages = [[NSMutableData alloc] init];
+
+    [result.errorArray appendArchiveToData:messages];
+
+    JSDTidyResultBlobHeader header;
+
+    memset(&header, 0, sizeof(header));
+
+    header.magic                   = JSDResultBlobMagic;
+    header.version                 = JSDResultBlobVersion;
+    header.key                     = result.key;
+    header.tidyDetectedHtmlVersion = result.tidyDetectedHtmlVersion;
+    header.tidyDetectedXhtml       = result.tidyDetectedXhtml;
+    header.tidyDetectedGenericXml  = result.tidyDetectedGenericXml;
+    header.tidyStatus              = result.tidyStatus;
+    header.tidyErrorCount          = result.tidyErrorCount;
+    header.tidyWarningCount        = result.tidyWarningCount;
+    header.tidyAccessWarningCount  = result.tidyAccessWarningCount;
+    header.tidyDataLength          = result.tidyData.length;
+    header.errorTextLength         = strlen(errorText);
+    header.messagesLength          = messages.length;
+
+    NSMutableData *blob = [[NSMutableData alloc] initWithCapacity:sizeof(header) + header.tidyDataLength + header.errorTextLength + header.messagesLength];
+
+    [blob appendBytes:&header length:sizeof(header)];
+    [blob appendData:result.tidyData];
+    [blob appendBytes:errorText length:(NSUInteger)header.errorTextLength];
+    [blob appendData:messages];
+
+    return blob;
+}
+
+
+@end
@@ -0,0 +1,202 @@
+//
+//  JSDTidyRun.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+//  The classes that do the actual work with libtidy for JSDTidyModel and
+//  JSDTidyBatchProcessor. They're implemented in JSDTidyModel.m.
+//
+
+@import Foundation;
+@import HTMLTidy;
+
+#import "JSDTidyModel.h"
+#import "JSDTidyArena.h"
+#import "JSDTidyCachedResult.h"
+
+@class JSDTidyMessageList;
+@class JSDTidyOptionSet;
+@class JSDTidyResultCache;
+
+
+#pragma mark - CLASS JSDTidyDocPool (private)
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyDocEntry
+ *   A TidyDoc along with the arena that it allocates from, and the
+ *   output and error buffers that we use with it. Entries are
+ *   recycled through a JSDTidyDocPool, so the arena and buffers
+ *   keep their grown capacity from run to run.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+
+typedef struct JSDTidyDocEntry {
+    JSDTidyArena arena;
+    TidyDoc      tidyDoc;
+    TidyBuffer   outBuffer;
+    TidyBuffer   errBuffer;
+} JSDTidyDocEntry;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyDocPool
+ *   A small, thread-safe pool of JSDTidyDocEntry. Each checked out
+ *   entry gets a fresh TidyDoc that allocates everything from the
+ *   entry's arena. When the entry is checked in, the TidyDoc is
+ *   released and the entire arena is reset in one step, so the
+ *   thousands of nodes and attributes from a parse never touch
+ *   malloc individually.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+
+@class JSDTidyParsedDoc;
+
+@interface JSDTidyDocPool : NSObject
+
+- (JSDTidyDocEntry *)checkOut;
+
+- (void)checkIn:(JSDTidyDocEntry *)entry;
+
+- (void)abandon:(JSDTidyDocEntry *)entry;
+
+- (JSDTidyParsedDoc *)takeParsedDoc;
+
+- (void)keepParsedDoc:(JSDTidyParsedDoc *)parsedDoc;
+
+@end
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyParsedDoc
+ *   An entry whose TidyDoc has already been parsed, cleaned, and
+ *   repaired, along with the results of doing so. The pool keeps
+ *   the most recent one after its run, so that when only output
+ *   options change, the next run only has to print it again.
+ *   Whoever holds a parsed doc owns its entry.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+
+@interface JSDTidyParsedDoc : NSObject
+
+@property (nonatomic, assign) JSDTidyDocEntry *entry;
+
+@property (nonatomic, assign) uint64_t parseFingerprint;          // Of the options it was parsed with.
+
+@property (nonatomic, strong) JSDTidyCachedResult *result;         // Its key identifies the source.
+
+@end
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyByteSource
+ *   State for a TidyInputSource that reads straight from a block
+ *   of UTF-8 bytes, so that libtidy can parse a memory mapped file
+ *   (or an NSString's own UTF-8 buffer) without another copy.
+ *   Setting `stopped` makes the rest of the bytes unreadable, which
+ *   is how a run ends parsing early. If there's an `arena`, its
+ *   deadline is checked every so often as the bytes are read.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDTidyByteSource {
+    const uint8_t *bytes;
+    size_t length;
+    size_t position;
+    bool stopped;
+    JSDTidyArena *arena;
+} JSDTidyByteSource;
+
+
+#pragma mark - CLASS JSDTidyRun (private)
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyRun
+ *   Encapsulates a single pass through libtidy. A run is prepared
+ *   on the calling thread (so that it captures a consistent
+ *   snapshot of the source text and options), can be executed on
+ *   any thread, and is then published to the owning model in a
+ *   single step. A run never touches its model while executing.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+
+@interface JSDTidyRun : NSObject
+
+/* Inputs */
+
+@property (nonatomic, assign) NSUInteger generation;              // The model generation this run represents.
+
+@property (nonatomic, strong) NSString *sourceText;               // Immutable snapshot of the source text.
+
+@property (nonatomic, strong) NSData *sourceData;                 // UTF-8 bytes to parse instead, e.g., a mapped file.
+
+@property (nonatomic, assign) JSDTidyDocEntry *entry;             // Configured TidyDoc; checked out by the run.
+
+@property (nonatomic, strong) JSDTidyDocPool *pool;               // The pool to which to return `entry`.
+
+@property (nonatomic, strong) JSDTidyResultCache *cache;          // Consulted before parsing; may be nil.
+
+@property (nonatomic, strong) JSDTidyOptionSet *options;          // The options `entry` was configured with.
+
+@property (nonatomic, assign) JSDTidyRunMode runMode;             // How much of the work to do.
+
+@property (nonatomic, assign) NSUInteger stopAfterReportCount;    // Stop parsing after this many; zero never stops.
+
+@property (nonatomic, assign) TidyReportLevel stopAtReportLevel;  // The level of the reports that are counted.
+
+@property (nonatomic, assign) NSTimeInterval timeBudget;          // Budgets for parsing and repair; zero for none.
+
+@property (nonatomic, assign) NSUInteger allocationBudget;
+
+@property (nonatomic, assign) NSUInteger memoryBudget;
+
+/* Results */
+
+@property (nonatomic, strong) NSData *tidyData;                   // UTF-8, LF output; owns libtidy's buffer.
+
+@property (nonatomic, strong) NSString *errorText;
+
+@property (nonatomic, strong) JSDTidyMessageList *errorArray;
+
+@property (nonatomic, assign) int tidyDetectedHtmlVersion;
+
+@property (nonatomic, assign) bool tidyDetectedXhtml;
+
+@property (nonatomic, assign) bool tidyDetectedGenericXml;
+
+@property (nonatomic, assign) int tidyStatus;
+
+@property (nonatomic, assign) uint tidyErrorCount;
+
+@property (nonatomic, assign) uint tidyWarningCount;
+
+@property (nonatomic, assign) uint tidyAccessWarningCount;
+
+@property (nonatomic, assign) NSUInteger allocationCount;
+
+@property (nonatomic, assign) NSUInteger allocationPeakBytes;
+
+@property (nonatomic, assign) BOOL resultWasCached;
+
+@property (nonatomic, assign) BOOL resultWasReprinted;
+
+@property (nonatomic, assign) BOOL ignoresReports;                // Reports from printing again aren't recorded.
+
+@property (nonatomic, assign) BOOL outputDeferred;                // `tidyData` is to be printed when it's read.
+
+@property (nonatomic, assign) BOOL stoppedEarly;                  // Parsing ended at `stopAfterReportCount`.
+
+@property (nonatomic, assign) NSUInteger stopReportCount;         // Reports at `stopAtReportLevel` so far.
+
+@property (nonatomic, assign) JSDTidyByteSource *parsingSource;   // The source being parsed, for stopping.
+
+@property (nonatomic, assign) JSDTidyBudgetStatus budgetStatus;   // The budget that ended the parse, if any.
+
+- (void)execute;
+
+- (NSDictionary<NSString *, NSData *> *)executePrintingOptionSets:(NSDictionary<NSString *, JSDTidyOptionSet *> *)optionSets;
+
+- (bool)errorFilterWithLocalization:(TidyDoc)tDoc
+                              Level:(TidyReportLevel)lvl
+                               Line:(uint)line
+                             Column:(uint)col
+                            Message:(ctmbstr)code
+                          Arguments:(va_list)args;
+
+@end
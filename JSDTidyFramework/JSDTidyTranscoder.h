@@ -0,0 +1,42 @@
+//
+//  JSDTidyTranscoder.h
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+@import Foundation;
+
+@import HTMLTidy;
+
+
+/**
+ *  Converts @b libtidy's UTF-8, @b LF output into the bytes that should be
+ *  saved, expanding line endings and encoding to the target character set
+ *  in a single pass over the input and straight into the result.
+ *
+ *  Blocks of ASCII text without a newline are copied a vector at a time
+ *  (SSE2 or NEON, or eight bytes at a time otherwise), which is the
+ *  common case for HTML in any of the supported encodings.
+ */
+
+
+/**
+ *  Indicates whether @c JSDTidyTranscodeUTF8() can produce @c encoding.
+ *  Currently UTF-8, ASCII, and ISO Latin-1 are supported.
+ */
+BOOL JSDTidyTranscoderSupportsEncoding( NSStringEncoding encoding );
+
+/**
+ *  Transcodes UTF-8 text with @b LF line endings.
+ *
+ *  @param bytes The UTF-8 text.
+ *  @param length The number of bytes of text.
+ *  @param encoding The encoding to produce, which must be supported.
+ *  @param lineEnding The line ending with which to replace each @b LF.
+ *
+ *  @return Returns the transcoded data, or nil if the text contains a
+ *    character that can't be represented in @c encoding (just as
+ *    @c -[NSString @c dataUsingEncoding:] does), or isn't valid UTF-8.
+ */
+NSData *JSDTidyTranscodeUTF8( const uint8_t *bytes, size_t length, NSStringEncoding encoding, TidyLineEnding lineEnding );
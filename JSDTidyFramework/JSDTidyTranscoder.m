@@ -0,0 +1,247 @@
+//
+//  JSDTidyTranscoder.m
+//  JSSDTidyFramework
+//
+//  Copyright © 2003-2019 by Jim Derry. All rights reserved.
+//
+
+#import "JSDTidyTranscoder.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+#pragma mark - Definitions
+
+
+typedef enum JSDTranscodeTarget {
+    JSDTranscodeTargetUTF8,
+    JSDTranscodeTargetASCII,
+    JSDTranscodeTargetLatin1,
+} JSDTranscodeTarget;
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTranscodeOutput
+ *   A growable output buffer. Output is about the same size as the
+ *   input, so it starts there with a little headroom for newline
+ *   expansion, and only grows if that runs out.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+typedef struct JSDTranscodeOutput {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+} JSDTranscodeOutput;
+
+
+static inline BOOL JSDTranscodeReserve( JSDTranscodeOutput *output, size_t needed )
+{
+    if (output->capacity - output->length >= needed)
+    {
+        return YES;
+    }
+
+    size_t capacity = MAX(output->capacity + output->capacity / 2, output->length + needed);
+    uint8_t *bytes = realloc(output->bytes, capacity);
+
+    if (!bytes)
+    {
+        return NO;
+    }
+
+    output->bytes = bytes;
+    output->capacity = capacity;
+
+    return YES;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTranscodePlainRun
+ *   Returns the length of the run of ASCII bytes at the start of
+ *   `bytes` that contains no LF, checking whole blocks at a time.
+ *   The run may stop short by less than a block; the caller's
+ *   scalar loop picks up from there.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+static inline size_t JSDTranscodePlainRun( const uint8_t *bytes, size_t length )
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(bytes + i));
+
+        if (_mm_movemask_epi8(_mm_or_si128(chunk, _mm_cmpeq_epi8(chunk, lf))))
+        {
+            break;
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t lf = vdupq_n_u8('\n');
+    const uint8x16_t high = vdupq_n_u8(0x80);
+
+    for (; i + 16 <= length; i += 16)
+    {
+        uint8x16_t chunk = vld1q_u8(bytes + i);
+
+        if (vmaxvq_u8(vorrq_u8(vcgeq_u8(chunk, high), vceqq_u8(chunk, lf))))
+        {
+            break;
+        }
+    }
+#else
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
+
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+
+        uint64_t lfs = word ^ (ones * '\n');
+
+        /* Any high bit, or any zero byte in `lfs` (i.e., an LF). */
+        if ((word | ((lfs - ones) & ~lfs)) & highs)
+        {
+            break;
+        }
+    }
+#endif
+
+    return i;
+}
+
+
+#pragma mark - Public Functions
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyTranscoderSupportsEncoding
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+BOOL JSDTidyTranscoderSupportsEncoding( NSStringEncoding encoding )
+{
+    return encoding == NSUTF8StringEncoding || encoding == NSASCIIStringEncoding || encoding == NSISOLatin1StringEncoding;
+}
+
+
+/*–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*
+ * JSDTidyTranscodeUTF8
+ *   Plain ASCII runs are copied in bulk; everything else (newlines
+ *   and multibyte sequences) is handled a character at a time.
+ *–––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––––*/
+NSData *JSDTidyTranscodeUTF8( const uint8_t *bytes, size_t length, NSStringEncoding encoding, TidyLineEnding lineEnding )
+{
+    JSDTranscodeTarget target;
+
+    switch (encoding)
+    {
+        case NSUTF8StringEncoding:
+            target = JSDTranscodeTargetUTF8;
+            break;
+        case NSASCIIStringEncoding:
+            target = JSDTranscodeTargetASCII;
+            break;
+        case NSISOLatin1StringEncoding:
+            target = JSDTranscodeTargetLatin1;
+            break;
+        default:
+            return nil;
+    }
+
+    JSDTranscodeOutput output = { NULL, 0, 0 };
+
+    if (!JSDTranscodeReserve(&output, length + length / 32 + 16))
+    {
+        return nil;
+    }
+
+    size_t i = 0;
+
+    while (i < length)
+    {
+        size_t run = JSDTranscodePlainRun(bytes + i, length - i);
+
+        if (run)
+        {
+            if (!JSDTranscodeReserve(&output, run))
+            {
+                goto fail;
+            }
+
+            memcpy(output.bytes + output.length, bytes + i, run);
+            output.length += run;
+            i += run;
+            continue;
+        }
+
+        uint8_t lead = bytes[i];
+
+        if (!JSDTranscodeReserve(&output, 4))
+        {
+            goto fail;
+        }
+
+        if (lead == '\n')
+        {
+            if (lineEnding == TidyCRLF)
+            {
+                output.bytes[output.length++] = '\r';
+                output.bytes[output.length++] = '\n';
+            }
+            else
+            {
+                output.bytes[output.length++] = lineEnding == TidyCR ? '\r' : '\n';
+            }
+
+            i++;
+            continue;
+        }
+
+        if (lead < 0x80)
+        {
+            output.bytes[output.length++] = lead;
+            i++;
+            continue;
+        }
+
+        /* A multibyte sequence. libtidy's output is well formed, but
+         * check anyway rather than read past the end.
+         */
+
+        size_t sequenceLength = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+
+        if (sequenceLength == 0 || i + sequenceLength > length)
+        {
+            goto fail;
+        }
+
+        if (target == JSDTranscodeTargetUTF8)
+        {
+            memcpy(output.bytes + output.length, bytes + i, sequenceLength);
+            output.length += sequenceLength;
+        }
+        else if (target == JSDTranscodeTargetLatin1 && sequenceLength == 2 && lead <= 0xC3)
+        {
+            output.bytes[output.length++] = (uint8_t)(((lead & 0x1F) << 6) | (bytes[i + 1] & 0x3F));
+        }
+        else
+        {
+            goto fail;
+        }
+
+        i += sequenceLength;
+    }
+
+    return [[NSData alloc] initWithBytesNoCopy:output.bytes length:output.length freeWhenDone:YES];
+
+fail:
+    free(output.bytes);
+
+    return nil;
+}